@@ -1,5 +1,11 @@
 #define ICI_CORE
 #include "fwd.h"
+#include "object.h"
+
+#ifdef ICI_USE_MADVISE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 /*
  * The amount of memory we currently have allocated, and a limit.
@@ -22,15 +28,26 @@ long                    ici_alloc_mem;
 #if !ICI_ALLALLOC
 
 /*
- * A chunk of memory in which to keep dense allocations of small
- * objects to avoid boundary word overheads and allow simple fast
- * free lists.
+ * Small blocks, of up to 1K, are carved from runs of ARUN_SIZE bytes.  A run
+ * holds blocks of just one of the sizes of our fast free lists, but once it
+ * is found to be entirely free (see ici_trim_alloc()) its memory is given
+ * back to the system and it may later be used for any size.
+ */
+#define ARUN_SIZE       (64 * 1024)
+
+/*
+ * The first block in a run.
  */
-typedef struct achunk   achunk_t;
-struct achunk
+#define arun_start(r)   ((char *)(((unsigned long)(r) + 0x3F) & ~0x3F))
+
+typedef struct arun     arun_t;
+struct arun
 {
-    char                c_data[1024];
-    achunk_t            *c_next;
+    char                *r_base;        /* As got from malloc(). */
+    int                 r_nfree;        /* Blocks on free lists. */
+    char                r_flist;        /* Which free list. */
+    char                r_busy;         /* Still being carved. */
+    char                r_empty;        /* Entirely free. */
 };
 
 /*
@@ -39,27 +56,124 @@ struct achunk
 char                    *ici_fltmp;
 
 /*
- * The base pointers of our four fast free lists.
+ * The base pointers of our fast free lists, and the size of the blocks on
+ * each.
+ */
+char                    *ici_flists[ICI_NFLISTS];
+
+static short const      flist_size[ICI_NFLISTS] =
+{
+    8, 16, 32, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+/*
+ * Which free list a block of a given size goes on, indexed by
+ * (size + 7) >> 3.
  */
-char                    *ici_flists[4];
+static char const       which_flist[(1024 >> 3) + 1] =
+{
+     0,  0,  1,  2,  2,  3,  3,  3,  3,  4,  4,  4,  4,  5,  5,  5,
+     5,  6,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,  7,  7,  7,  7,
+     7,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,
+     8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,
+     9, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+    10, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+    11,
+};
 
 /*
- * The current next available block, and limits, within each of
- * the allocation chunks for each of the size categories we have
- * for small objects.
+ * The current next available block, and limits, within the run being
+ * carved for each of the free lists.
  */
-static char             *mem_next[4];
-static char             *mem_limit[4];
+static char             *mem_next[ICI_NFLISTS];
+static char             *mem_limit[ICI_NFLISTS];
 
 /*
- * The global list of all chunks of small dense objects we have allocated.
- * We just keep this so we can free them all on interpreter shutdown.
+ * All the runs with blocks in them (sorted by address after a call to
+ * ici_trim_alloc()), and the runs that are empty and can be used again.
  */
-static achunk_t         *ici_achunks;
+static arun_t           *aruns;
+static int              naruns;
+static int              aruns_limit;
+static char             **aruns_idle;
+static int              naruns_idle;
+static int              aruns_idle_limit;
+
+/*
+ * Start carving blocks for the free list 'fi' from a new run, using an
+ * empty one if there is one.  Returns non-zero on failure.
+ */
+static int
+new_run(int fi)
+{
+    arun_t              *a;
+    char                *r;
+    int                 n;
+
+    if (naruns == aruns_limit)
+    {
+        n = aruns_limit == 0 ? 64 : aruns_limit * 2;
+        if ((a = (arun_t *)realloc(aruns, n * sizeof(arun_t))) == NULL)
+            return 1;
+        aruns = a;
+        aruns_limit = n;
+    }
+    if (naruns_idle == 0 && (r = (char *)malloc(ARUN_SIZE)) == NULL)
+    {
+        collect();
+        if (naruns_idle == 0 && (r = (char *)malloc(ARUN_SIZE)) == NULL)
+            return 1;
+    }
+    if (naruns_idle != 0)
+        r = aruns_idle[--naruns_idle];
+    aruns[naruns++].r_base = r;
+    mem_next[fi] = arun_start(r);
+    mem_limit[fi] = r + ARUN_SIZE;
+    return 0;
+}
 
 #endif /* ICI_ALLALLOC */
 
 
+/*
+ * Set when an allocation has failed for want of room under ici_gc_ceiling,
+ * until a collection finds the heap back under it.  In the meantime, what
+ * is done in handling the failure may take the heap an eighth past it.
+ */
+static int              mem_past_ceiling;
+
+/*
+ * Called when an allocation of 'z' bytes, already counted in ici_mem_used,
+ * has taken it past ici_mem_limit.  Collects, and if a hard ceiling is set
+ * (see ici_gc_ceiling) and the heap is still above it, makes one last full
+ * collection before giving up.  Returns non-zero, usual conventions, if the
+ * allocation must fail.
+ */
+static int
+mem_over(size_t z)
+{
+    long                limit;
+
+    collect();
+    if (ici_gc_ceiling <= 0 || ici_supress_collect)
+        return 0;
+    limit = ici_gc_ceiling;
+    if (mem_past_ceiling)
+        limit += ici_gc_ceiling / 8;
+    if (ici_mem_used > limit)
+        ici_reclaim();
+    if (ici_mem_used <= ici_gc_ceiling)
+        mem_past_ceiling = 0;
+    if (ici_mem_used <= limit)
+        return 0;
+    ici_mem_used -= z;
+    mem_past_ceiling = 1;
+    ici_error = "ran out of memory (heap ceiling reached)";
+    return 1;
+}
+
 /*
  * Allocate an object of the given 'size'.  Return NULL on failure, usual
  * conventions.  The resulting object must be freed with ici_nfree() and only
@@ -80,62 +194,37 @@ void *
 ici_nalloc(size_t z)
 {
     char                *r;
-    static char const   which_flist[] = {0, 1, 2, 2, 3, 3, 3, 3};
-
 
-    if ((ici_mem_used += z) > ici_mem_limit)
-        collect();
+    if ((ici_mem_used += z) > ici_mem_limit && mem_over(z))
+        return NULL;
 
 #if !ICI_ALLALLOC
+    if (z <= 1024)
     {
-        int     fi;
-        if (z <= 64)
-            fi = which_flist[(z - 1) >> 3];
-        else
-            fi = z;
-        if (fi < nels(ici_flists))
+        int             fi;
+        char            **fp;
+        int             cz;
+
+        /*
+         * Small block. Try to get it off one of the fast free lists.
+         */
+        fi = which_flist[(z + 7) >> 3];
+        fp = &ici_flists[fi];
+        if ((r = *fp) != NULL)
         {
-            char                **fp;
-            int                 cz;
-            achunk_t            *c;
-
-            /*
-             * Small block. Try to get it off one of the fast free lists.
-             */
-            fp = &ici_flists[fi];
-            if ((r = *fp) != NULL)
-            {
-                *fp = *(char **)r;
-                return r;
-            }
-            /*
-             * Free list empty. Rip off a bit more memory from the current
-             * chunk.
-             */
-            cz = 8 << fi;
-            if (mem_next[fi] + cz <= mem_limit[fi])
-            {
-                r = mem_next[fi];
-                mem_next[fi] += cz;
-                return r;
-            }
-            /*
-             * Current chunk empty. Allocate another one.
-             */
-            if ((c = (achunk_t *)malloc(sizeof(achunk_t))) == NULL)
-            {
-                collect();
-                if ((c = (achunk_t *)malloc(sizeof(achunk_t))) == NULL)
-                    goto fail;
-            }
-            c->c_next = ici_achunks;
-            ici_achunks = c;
-            mem_next[fi] = (char *)(((unsigned long)c->c_data + 0x3F) & ~0x3F);
-            mem_limit[fi] = &c->c_data[nels(c->c_data)];
-            r = mem_next[fi];
-            mem_next[fi] += cz;
+            *fp = *(char **)r;
             return r;
         }
+        /*
+         * Free list empty. Rip off a bit more memory from the current
+         * run, or start another one.
+         */
+        cz = flist_size[fi];
+        if (mem_next[fi] + cz > mem_limit[fi] && new_run(fi))
+            goto fail;
+        r = mem_next[fi];
+        mem_next[fi] += cz;
+        return r;
     }
 #endif /* ICI_ALLALLOC */
 
@@ -165,17 +254,15 @@ fail:
 void
 ici_nfree(void *p, size_t z)
 {
-    static char const   which_flist[] = {0, 1, 2, 2, 3, 3, 3, 3};
-
     ici_mem_used -= z;
 #if !ICI_ALLALLOC
-    if (z <= 64)
+    if (z <= 1024)
     {
         int     fi;
         /*
          * Small block. Just push it onto one of our fast free lists.
          */
-        fi = which_flist[(z - 1) >> 3];
+        fi = which_flist[(z + 7) >> 3];
         *(char **)p = ici_flists[fi];
         ici_flists[fi] = (char *)p;
     }
@@ -212,8 +299,8 @@ ici_alloc(size_t z)
 #if ALLCOLLECT
     collect();
 #else
-    if ((ici_mem_used += z) > ici_mem_limit)
-        collect();
+    if ((ici_mem_used += z) > ici_mem_limit && mem_over(z))
+        return NULL;
 #endif
 
     ++ici_n_allocs;
@@ -260,6 +347,184 @@ ici_free(void *p)
     free(p);
 }
 
+#if !ICI_ALLALLOC
+static int
+arun_cmp(const void *a, const void *b)
+{
+    return ((arun_t *)a)->r_base < ((arun_t *)b)->r_base ? -1
+        : ((arun_t *)a)->r_base > ((arun_t *)b)->r_base;
+}
+
+/*
+ * Return the run the block 'p' was carved from, or NULL.  aruns[] must be
+ * sorted.
+ */
+static arun_t *
+find_run(char *p)
+{
+    int                 lo;
+    int                 hi;
+    int                 m;
+
+    lo = 0;
+    hi = naruns;
+    while (lo < hi)
+    {
+        m = (lo + hi) >> 1;
+        if (aruns[m].r_base <= p)
+            lo = m + 1;
+        else
+            hi = m;
+    }
+    if (lo == 0 || p >= aruns[lo - 1].r_base + ARUN_SIZE)
+        return NULL;
+    return &aruns[lo - 1];
+}
+#endif /* ICI_ALLALLOC */
+
+/*
+ * Give the memory of runs of small blocks that are entirely free back to
+ * the system.  We count the blocks on the free lists from each run, and
+ * take those from runs that turn out to be empty off the lists again.
+ * The runs are kept to be used again, but their pages are given back with
+ * madvise(), where we have it, and otherwise they are freed.  This is done
+ * after each major garbage collection that leaves the runs less than half
+ * used.
+ */
+void
+ici_trim_alloc(void)
+{
+#if !ICI_ALLALLOC
+    arun_t              *r;
+    arun_t              *q;
+    char                *p;
+    char                **pp;
+    int                 fi;
+    int                 nempty;
+
+    /*
+     * Unless there is a lot of free memory in the runs, it isn't worth
+     * looking.
+     */
+    if (ici_mem_used >= (long)naruns * (ARUN_SIZE / 2))
+        return;
+    qsort(aruns, naruns, sizeof(arun_t), arun_cmp);
+    for (r = aruns; r < aruns + naruns; ++r)
+    {
+        r->r_nfree = 0;
+        r->r_busy = 0;
+        r->r_empty = 0;
+    }
+    for (fi = 0; fi < ICI_NFLISTS; ++fi)
+    {
+        if (mem_limit[fi] != NULL && (r = find_run(mem_limit[fi] - 1)) != NULL)
+            r->r_busy = 1;
+        for (p = ici_flists[fi]; p != NULL; p = *(char **)p)
+        {
+            if ((r = find_run(p)) != NULL)
+            {
+                ++r->r_nfree;
+                r->r_flist = fi;
+            }
+        }
+    }
+    nempty = 0;
+    for (r = aruns; r < aruns + naruns; ++r)
+    {
+        if
+        (
+            !r->r_busy
+            &&
+            r->r_nfree != 0
+            &&
+            r->r_nfree == (r->r_base + ARUN_SIZE - arun_start(r->r_base))
+                            / flist_size[(int)r->r_flist]
+        )
+        {
+            r->r_empty = 1;
+            ++nempty;
+        }
+    }
+    if (nempty == 0)
+        return;
+    for (fi = 0; fi < ICI_NFLISTS; ++fi)
+    {
+        for (pp = &ici_flists[fi]; (p = *pp) != NULL; )
+        {
+            if ((r = find_run(p)) != NULL && r->r_empty)
+                *pp = *(char **)p;
+            else
+                pp = (char **)p;
+        }
+    }
+    for (r = q = aruns; r < aruns + naruns; ++r)
+    {
+        if (!r->r_empty)
+        {
+            *q++ = *r;
+            continue;
+        }
+#       ifdef ICI_USE_MADVISE
+        {
+            unsigned long   pz;
+            char            *s;
+            char            *e;
+            char            **n;
+            int             z;
+
+            if (naruns_idle == aruns_idle_limit)
+            {
+                z = aruns_idle_limit == 0 ? 64 : aruns_idle_limit * 2;
+                if ((n = (char **)realloc(aruns_idle, z * sizeof(char *))) == NULL)
+                {
+                    free(r->r_base);
+                    continue;
+                }
+                aruns_idle = n;
+                aruns_idle_limit = z;
+            }
+            pz = sysconf(_SC_PAGESIZE);
+            s = (char *)(((unsigned long)r->r_base + pz - 1) & ~(pz - 1));
+            e = (char *)(((unsigned long)r->r_base + ARUN_SIZE) & ~(pz - 1));
+            if (e > s)
+                madvise(s, e - s, MADV_DONTNEED);
+            aruns_idle[naruns_idle++] = r->r_base;
+        }
+#       else
+            free(r->r_base);
+#       endif
+    }
+    naruns = q - aruns;
+#endif /* ICI_ALLALLOC */
+}
+
+/*
+ * Fill in the parts of '*gs' that concern the allocator.  See
+ * ici_gc_stats().
+ */
+void
+ici_alloc_stats(ici_gcstats_t *gs)
+{
+#if !ICI_ALLALLOC
+    int                 i;
+    char                *p;
+#endif
+
+    gs->gs_n_allocs = ici_n_allocs;
+    gs->gs_alloc_mem = ici_alloc_mem;
+#if !ICI_ALLALLOC
+    for (i = 0; i < ICI_NFLISTS; ++i)
+    {
+        gs->gs_flist_size[i] = flist_size[i];
+        gs->gs_flist_free[i] = 0;
+        for (p = ici_flists[i]; p != NULL; p = *(char **)p)
+            ++gs->gs_flist_free[i];
+    }
+    gs->gs_runs = naruns;
+    gs->gs_idle_runs = naruns_idle;
+#endif
+}
+
 /*
  * Initialize the memory allocation system.
  */
@@ -278,8 +543,6 @@ ici_init_alloc(void)
     memset(ici_flists, 0, sizeof(ici_flists));
     memset(mem_next, 0, sizeof(mem_next));
     memset(mem_limit, 0, sizeof(mem_limit));
-
-    ici_achunks = NULL;
 #endif /* ICI_ALLALLOC */
 
     return 0;
@@ -294,12 +557,15 @@ void
 ici_uninit_alloc(void)
 {
 #if !ICI_ALLALLOC
-    achunk_t            *c;
-
-    while ((c = ici_achunks) != NULL)
-    {
-        ici_achunks = c->c_next;
-        free(c);
-    }
+    while (naruns > 0)
+        free(aruns[--naruns].r_base);
+    while (naruns_idle > 0)
+        free(aruns_idle[--naruns_idle]);
+    free(aruns);
+    free(aruns_idle);
+    aruns = NULL;
+    aruns_limit = 0;
+    aruns_idle = NULL;
+    aruns_idle_limit = 0;
 #endif /* ICI_ALLALLOC */
 }
@@ -58,18 +58,26 @@ extern void             ici_free(void *);
  * Is an object of this type of a size suitable for one of the
  * fast free lists?
  */
-#define ICI_FLOK(t)     (sizeof(t) <= 64)
+#define ICI_FLOK(t)     (sizeof(t) <= 1024)
 
 /*
  * Determine what free list an object of the given type is appropriate
  * for, or the size of the object if it is too big. We assume the
  * compiler will reduce this constant expression to a constant at
- * compile time.
+ * compile time.  The sizes must match flist_size[] in alloc.c.
  */
-#define ICI_FLIST(t)    (sizeof(t) <=  8 ? 0  \
-                        : sizeof(t) <= 16 ? 1 \
-                        : sizeof(t) <= 32 ? 2 \
-                        : sizeof(t) <= 64 ? 3 \
+#define ICI_FLIST(t)    (sizeof(t) <=    8 ?  0 \
+                        : sizeof(t) <=   16 ?  1 \
+                        : sizeof(t) <=   32 ?  2 \
+                        : sizeof(t) <=   64 ?  3 \
+                        : sizeof(t) <=   96 ?  4 \
+                        : sizeof(t) <=  128 ?  5 \
+                        : sizeof(t) <=  192 ?  6 \
+                        : sizeof(t) <=  256 ?  7 \
+                        : sizeof(t) <=  384 ?  8 \
+                        : sizeof(t) <=  512 ?  9 \
+                        : sizeof(t) <=  768 ? 10 \
+                        : sizeof(t) <= 1024 ? 11 \
                         : sizeof(t))
 
 /*
@@ -94,7 +102,7 @@ extern void             ici_free(void *);
             ici_mem_used -= sizeof(t))                  \
         : (ici_nfree((p), sizeof(t)), 0))
 
-extern char             *ici_flists[4];
+extern char             *ici_flists[ICI_NFLISTS];
 extern char             *ici_fltmp;
 
 #endif  /* ICI_ALLALLOC */
@@ -104,5 +112,7 @@ extern long             ici_mem_limit;
 
 extern int              ici_init_alloc();
 extern void             ici_uninit_alloc();
+extern void             ici_trim_alloc(void);
+extern void             ici_alloc_stats(ici_gcstats_t *);
 
 #endif /* ICI_ALLOC_H */
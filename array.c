@@ -196,6 +196,7 @@ ici_array_push(ici_array_t *a, ici_obj_t *o)
         /* 'a' is a stack; if there are no empty slots we must grow it. */
         if (a->a_top == a->a_limit && ici_array_grow(a))
             return 1;
+        ici_wb(a);
         *a->a_top++ = o;
     }
     else
@@ -203,6 +204,7 @@ ici_array_push(ici_array_t *a, ici_obj_t *o)
         /* 'a' is a queue; if full we must convert it to a larger stack. */
         if (a->a_top == a->a_bot - 1 && ici_array_grow(a))
             return 1;
+        ici_wb(a);
         *a->a_top++ = o;
         /*
          * To meet our invariants for queues (a_bot and a_top strictly less
@@ -253,6 +255,7 @@ ici_array_rpush(ici_array_t *a, ici_obj_t *o)
         a->a_bot = a->a_limit;
     }
     /* Push the element at a_bot[-1]. This ensures a_bot < a_limit. */
+    ici_wb(a);
     *--a->a_bot = o;
     return 0;
 }
@@ -563,6 +566,7 @@ assign_array(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
     }
     if ((e = ici_array_find_slot(arrayof(o), i)) == NULL)
         return 1;
+    ici_wb(o);
     *e = v;
     return 0;
 }
@@ -365,9 +365,10 @@
         {
             o = objof
                 (
-                    ici_str_new
+                    ici_str_sub
                     (
-                        stringof(o1)->s_chars + re_bra[2],
+                        stringof(o1),
+                        re_bra[2],
                         re_bra[3] - re_bra[2]
                     )
                 );
@@ -414,9 +415,10 @@
                     =
                     objof
                     (
-                        ici_str_new
+                        ici_str_sub
                         (
-                            stringof(o1)->s_chars + re_bra[i*2],
+                            stringof(o1),
+                            re_bra[i*2],
                             re_bra[(i * 2) + 1 ] - re_bra[i * 2]
                         )
                     )
@@ -470,8 +472,16 @@
         }
         goto looseo;
 
-    case TRI(TC_STRING, TC_STRING, T_PLUS):
     case TRI(TC_STRING, TC_STRING, T_PLUSEQ):
+        /*
+         * aggr key value string => ... (os).  See ici_str_append().
+         */
+        o = objof(ici_str_append(stringof(o0), stringof(o1), isstruct(ici_os.a_top[-4])));
+        if (o == NULL)
+            goto fail;
+        goto looseo;
+
+    case TRI(TC_STRING, TC_STRING, T_PLUS):
         if ((o = objof(ici_str_alloc(stringof(o1)->s_nchars
             + stringof(o0)->s_nchars))) == NULL)
             goto fail;
@@ -487,7 +497,7 @@
             stringof(o1)->s_chars,
             stringof(o1)->s_nchars + 1
         );
-        o = ici_atom(o, 1);
+        o = objof(ici_str_lazy(stringof(o)));
         goto looseo;
 
     case TRI(TC_ARRAY, TC_ARRAY, T_PLUS):
@@ -523,7 +533,7 @@
             {
                 if (sl->sl_key == NULL)
                     continue;
-                if (ici_assign(s, sl->sl_key, sl->sl_value))
+                if (ici_assign(s, sl->sl_key, ici_fetched(sl->sl_value)))
                 {
                     ici_decref(s);
                     goto fail;
@@ -748,68 +758,38 @@ usef:
             if ((o = objof(ici_talloc(ici_ostemp_t))) == NULL)
                 goto fail;
             ici_exec->x_os_temp_cache->a_base[n] = o;
+            o->o_flags = 0;
             ici_rego(o);
         }
-        ICI_OBJ_SET_TFNZ(o, TC_FLOAT, O_TEMP, 0, sizeof(ici_ostemp_t));
+        /*
+         * A re-used temp may be old, so it keeps its O_MARK.
+         */
+        ICI_OBJ_SET_TFNZ(o, TC_FLOAT, O_TEMP | (o->o_flags & O_MARK), 0, sizeof(ici_ostemp_t));
         floatof(o)->f_value = f;
         goto useo;
     }
     /*
-     * The following in-line expansion of float creation replaces, and
-     * this should be equivalent to, this old code:
-     *
-     * if ((o = objof(ici_float_new(f))) == NULL)
-     *     goto fail;
-     * goto looseo;
+     * A float result is not made an atom.  Doing that would mean hashing
+     * it and probing the atom pool here, and the pool filling with dead
+     * floats that the collector must take out again.  Floats are only made
+     * atoms if they are used as keys (see ici_keyof() in object.h).
      */
+    if ((o = objof(ici_talloc(ici_float_t))) == NULL)
+        goto fail;
+    ICI_OBJ_SET_TFNZ(o, TC_FLOAT, 0, 1, sizeof(ici_float_t));
+    floatof(o)->f_value = f;
+    ici_rego(o);
+    goto looseo;
 
+usei:
     /*
-     * In-line expansion of float creation.
+     * A small int is already made, which is cheaper even than a temp.
      */
+    if (ici_is_small_int(i))
     {
-        ici_obj_t               **po;
-        union
-        {
-            double              f;
-            long                l[2];
-        }
-            v;
-        unsigned long           h;
-
-        /*
-         * If this assert fails, we should switch back to a an explicit call
-         * to hash_float().
-         */
-        assert(sizeof floatof(o)->f_value == 2 * sizeof(unsigned long));
-        v.f = f;
-        h = FLOAT_PRIME + v.l[0] + v.l[1] * 31;
-        h ^= (h >> 12) ^ (h >> 24);
-        for
-        (
-            po = &atoms[ici_atom_hash_index(h)];
-            (o = *po) != NULL;
-            --po < atoms ? po = atoms + atomsz - 1 : NULL
-        )
-        {
-            if (isfloat(o) && DBL_BIT_CMP(&floatof(o)->f_value, &v.l))
-                goto useo;
-        }
-        ++ici_supress_collect;
-        if ((o = objof(ici_talloc(ici_float_t))) == NULL)
-        {
-            --ici_supress_collect;
-            goto fail;
-        }
-        ICI_OBJ_SET_TFNZ(o, TC_FLOAT, O_ATOM, 1, sizeof(ici_float_t));
-        floatof(o)->f_value = f;
-        ici_rego(o);
-        assert(h == hash(o));
-        --ici_supress_collect;
-        ICI_STORE_ATOM_AND_COUNT(po, o);
-        goto looseo;
+        o = objof(ici_small_int(i));
+        goto useo;
     }
-
-usei:
     if (can_temp)
     {
         int             n;
@@ -822,9 +802,13 @@ usei:
             if ((o = objof(ici_talloc(ici_ostemp_t))) == NULL)
                 goto fail;
             ici_exec->x_os_temp_cache->a_base[n] = o;
+            o->o_flags = 0;
             ici_rego(o);
         }
-        ICI_OBJ_SET_TFNZ(o, TC_INT, O_TEMP, 0, sizeof(ici_ostemp_t));
+        /*
+         * A re-used temp may be old, so it keeps its O_MARK.
+         */
+        ICI_OBJ_SET_TFNZ(o, TC_INT, O_TEMP | (o->o_flags & O_MARK), 0, sizeof(ici_ostemp_t));
         intof(o)->i_value = i;
         goto useo;
     }
@@ -832,11 +816,6 @@ usei:
      * In-line expansion of atom_int() from object.c. Following that, and
      * merged with it, is in-line atom creation.
      */
-    if ((i & ~ICI_SMALL_INT_MASK) == 0)
-    {
-        o = objof(ici_small_ints[i]);
-        goto useo;
-    }
     {
         register ici_obj_t      **po;
 
@@ -847,7 +826,7 @@ usei:
             --po < atoms ? po = atoms + atomsz - 1 : NULL
         )
         {
-            if (isint(o) && intof(o)->i_value == i)
+            if (isint(o) && intof(o)->i_value == i && !ici_atom_dead(o))
                 goto useo;
         }
         ++ici_supress_collect;
@@ -860,6 +839,7 @@ usei:
         intof(o)->i_value = i;
         ici_rego(o);
         --ici_supress_collect;
+        atom_hashes[po - atoms] = (unsigned long)i * INT_PRIME;
         ICI_STORE_ATOM_AND_COUNT(po, o);
     }
 
@@ -9,16 +9,23 @@
 #include "catch.h"
 #include "op.h"
 #include "func.h"
+#include "struct.h"
 
 /*
  * Unwind the execution stack until a catcher is found.  Then unwind
  * the scope and operand stacks to the matching depth (but only if it is).
  * Returns the catcher, or NULL if there wasn't one.
+ *
+ * The autos of function calls abandoned on the way are kept for the next
+ * call, as they would have been if the calls had returned (see
+ * keep_autos()).  So code that fails out of functions a lot doesn't make
+ * new ones each time.
  */
 ici_catch_t *
 ici_unwind()
 {
     ici_obj_t   **p;
+    ici_obj_t   **v;
     ici_catch_t *c;
 
     for (p = ici_xs.a_top - 1; p >= ici_xs.a_base; --p)
@@ -28,6 +35,11 @@ ici_unwind()
             c = catchof(*p);
             ici_xs.a_top = p;
             ici_os.a_top = &ici_os.a_base[c->c_odepth];
+            for (v = ici_vs.a_top; --v >= &ici_vs.a_base[c->c_vdepth]; )
+            {
+                if ((*v)->o_flags & S_FRAME && isstruct(*v))
+                    keep_autos(structof(*v));
+            }
             ici_vs.a_top = &ici_vs.a_base[c->c_vdepth];
             return c;
         }
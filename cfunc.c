@@ -1028,6 +1028,23 @@ f_eq()
         return 1;
     if (o1 == o2)
         return ici_ret_no_decref(objof(ici_one));
+    /*
+     * A lazy atom is the same object as its atom, as far as the program
+     * can tell, but they need not be made atoms just to find that out.
+     */
+    if
+    (
+        (ici_is_lazy_atom(o1) || ici_is_lazy_atom(o2))
+        &&
+        (ici_is_lazy_atom(o1) || (o1->o_flags & O_ATOM) != 0)
+        &&
+        (ici_is_lazy_atom(o2) || (o2->o_flags & O_ATOM) != 0)
+        &&
+        o1->o_tcode == o2->o_tcode
+        &&
+        cmp(o1, o2) == 0
+    )
+        return ici_ret_no_decref(objof(ici_one));
     return ici_ret_no_decref(objof(ici_zero));
 }
 
@@ -1180,6 +1197,7 @@ f_include()
         if (ici_typecheck("o", &filename))
             return 1;
         a = structof(ici_vs.a_top[-1]);
+        objof(a)->o_flags &= ~S_FRAME;
         break;
 
     case 2:
@@ -1318,13 +1336,24 @@ static int
 f_fail()
 {
     char        *s;
+    size_t      n;
 
     if (ici_typecheck("s", &s))
         return 1;
-    if (ici_chkbuf(strlen(s)))
+    if (ici_chkbuf(n = strlen(s)))
         return 1;
     strcpy(buf, s);
     ici_error = buf;
+    /*
+     * If caught, the error variable can just be set to our argument.
+     */
+    if
+    (
+        (ARG(0)->o_flags & (ICI_S_SEP_ALLOC|ICI_S_READONLY)) != ICI_S_SEP_ALLOC
+        &&
+        (size_t)stringof(ARG(0))->s_nchars == n
+    )
+        ici_set_error_str(stringof(ARG(0)));
     return 1;
 }
 
@@ -1380,7 +1409,14 @@ f_vstack()
     int                 depth;
 
     if (NARGS() == 0)
+    {
+        for (depth = 0; depth < ici_vs.a_top - ici_vs.a_bot; ++depth)
+        {
+            if (isstruct(ici_vs.a_top[-depth - 1]))
+                ici_vs.a_top[-depth - 1]->o_flags &= ~S_FRAME;
+        }
         return ici_ret_with_decref(copy(objof(&ici_vs)));
+    }
 
     if (!isint(ARG(0)))
         return ici_argerror(0);
@@ -1389,6 +1425,8 @@ f_vstack()
         return ici_argerror(0);
     if (depth >= ici_vs.a_top - ici_vs.a_bot)
         return ici_null_ret();
+    if (isstruct(ici_vs.a_top[-depth - 1]))
+        ici_vs.a_top[-depth - 1]->o_flags &= ~S_FRAME;
     return ici_ret_no_decref(ici_vs.a_top[-depth - 1]);
 }
 
@@ -1492,7 +1530,7 @@ f_interval()
 
     if (o->o_tcode == TC_STRING)
     {
-        return ici_ret_with_decref(objof(ici_str_new(s->s_chars + start, (int)length)));
+        return ici_ret_with_decref(objof(ici_str_sub(s, (int)start, (int)length)));
     }
     else
     {
@@ -1571,7 +1609,7 @@ f_implode()
             break;
         }
     }
-    if ((s = stringof(ici_atom(objof(s), 1))) == NULL)
+    if ((s = ici_str_lazy(s)) == NULL)
         return 1;
     return ici_ret_with_decref(objof(s));
 }
@@ -2055,35 +2093,26 @@ f_del()
 static int
 super_loop(ici_objwsup_t *base)
 {
-    ici_objwsup_t       *s;
+    ici_objwsup_t       *slow;
+    ici_objwsup_t       *fast;
 
     /*
-     * Scan up the super chain setting the O_MARK flag as we go. If we hit
-     * a marked struct, we must have looped. Note that the O_MARK flag
-     * is a strictly transitory flag that can only be used in local
-     * non-allocating areas such as this. It must be left cleared at all
-     * times. The garbage collector assumes it is cleared on all objects
-     * when it runs.
+     * Walk up the super chain at two speeds. If the fast walker ever
+     * catches the slow one, we must have looped. (This used to use the
+     * O_MARK flag, but that is now owned by the garbage collector, which
+     * leaves it set on old objects between collections.)
      */
-    for (s = base; s != NULL; s = s->o_super)
+    slow = fast = base;
+    while (fast != NULL && (fast = fast->o_super) != NULL)
     {
-        if (objof(s)->o_flags & O_MARK)
+        fast = fast->o_super;
+        slow = slow->o_super;
+        if (fast == slow)
         {
-            /*
-             * A loop. Clear all the O_MARK flags we set and set error.
-             */
-            for (s = base; objof(s)->o_flags & O_MARK; s = s->o_super)
-                objof(s)->o_flags &= ~O_MARK;
             ici_error = "cycle in struct super chain";
             return 1;
         }
-        objof(s)->o_flags |= O_MARK;
     }
-    /*
-     * No loop. Clear all the O_MARK flags we set.
-     */
-    for (s = base; s != NULL; s = s->o_super)
-        objof(s)->o_flags &= ~O_MARK;
     return 0;
 }
 
@@ -2112,8 +2141,19 @@ f_super()
             newsuper = objwsupof(ARG(1));
         else
             return ici_argerror(1);
-        ++ici_vsver;
+        /*
+         * Look-asides based on o are easily invalidated, but those found
+         * through it, from other structs, can only be invalidated with all
+         * the rest.
+         */
+        if (isstruct(o) && (objof(o)->o_flags & S_LOOKASIDE_VIA) == 0)
+            structof(o)->s_vsver = ++ici_vsver;
+        else
+            ici_invalidate_lookasides();
+        if (isstruct(o))
+            ici_struct_changing(o);
     }
+    ici_wb(o);
     o->o_super = newsuper;
     if (super_loop(o))
     {
@@ -2131,6 +2171,7 @@ f_scope()
     ici_struct_t    *s;
 
     s = structof(ici_vs.a_top[-1]);
+    objof(s)->o_flags &= ~S_FRAME;
     if (NARGS() > 0)
     {
         if (ici_typecheck("d", &ici_vs.a_top[-1]))
@@ -2146,7 +2187,11 @@ f_isatom()
 
     if (ici_typecheck("o", &o))
         return 1;
-    if (o->o_flags & O_ATOM)
+    /*
+     * Lazy atoms only become atoms when they have to (see ici_keyof()), but
+     * as far as the program can tell they always are.
+     */
+    if ((o->o_flags & O_ATOM) != 0 || isfloat(o) || ici_is_lazy_atom(o))
         return ici_ret_no_decref(objof(ici_one));
     else
         return ici_ret_no_decref(objof(ici_zero));
@@ -2459,38 +2504,39 @@ f_gettoken()
 
 /*
  * Fast (relatively) version for gettokens() if argument is not file.
+ * The delimiters are made into a set first so each char is looked up
+ * once, and tokens are taken a run at a time.
  */
 static int
-fast_gettokens(char *str, char *delims)
+fast_gettokens(ici_str_t *str, char *delims, int ndelims)
 {
     ici_array_t *a;
-    int         k       = 0;
-    char        *cp     = str;
+    char        *cp     = str->s_chars;
+    char        *ce     = cp + str->s_nchars;
+    char        *te;
+    unsigned char set[ICI_BYTESETZ];
 
     if ((a = ici_array_new(0)) == NULL)
         return 1;
-    while (*cp)
+    ici_byteset(set, delims, ndelims);
+    for (;;)
     {
-        while (*cp && strchr(delims, *cp))
-            cp++;
-        if ((k = strcspn(cp, delims)))
+        if ((cp = ici_byte_span(cp, ce, set)) == ce)
+            break;
+        te = ici_byte_find(cp + 1, ce, set);
+        if
+        (
+            ici_stk_push_chk(a, 1)
+            ||
+            (*a->a_top = objof(ici_str_sub(str, cp - str->s_chars, te - cp))) == NULL
+        )
         {
-            if
-            (
-                ici_stk_push_chk(a, 1)
-                ||
-                (*a->a_top = objof(ici_str_new(cp, k))) == NULL
-            )
-            {
-                ici_decref(a);
-                return 1;
-            }
-            ici_decref(*a->a_top);
-            ++a->a_top;
-            if (*(cp += k))
-                cp++;
-            continue;
+            ici_decref(a);
+            return 1;
         }
+        ici_decref(*a->a_top);
+        ++a->a_top;
+        cp = te;
     }
     if (a->a_top == a->a_base)
     {
@@ -2513,15 +2559,21 @@ f_gettokens()
     int                 ndelims;
     int                 hardsep;
     unsigned char       sep;
-    char                *file;
+    char                *file = NULL; /* init to shut up compiler */
     ici_array_t         *a;
-    int                 (*get)();
+    int                 (*get)() = NULL; /* init to shut up compiler */
     int                 c;
     int                 i;
     int                 j = 0; /* init to shut up compiler */
     int                 state;
     int                 what;
-    int                 loose_it = 0;
+    char                *p = NULL;  /* Where we are up to if in a string. */
+    char                *e = NULL;
+    char                *q;
+    unsigned char       sepset[ICI_BYTESETZ];
+    unsigned char       termset[ICI_BYTESETZ];
+    unsigned char       delimset[ICI_BYTESETZ];
+    unsigned char       anyset[ICI_BYTESETZ];
 
     seps = (unsigned char *)" \t";
     nseps = 2;
@@ -2541,7 +2593,7 @@ f_gettokens()
             return 1;
         if (isstring(objof(f)))
         {
-            return fast_gettokens(stringof(f)->s_chars, " \t");
+            return fast_gettokens(stringof(f), " \t", 2);
         }
         else if (!isfile(objof(f)))
             return ici_argerror(0);
@@ -2554,13 +2606,12 @@ f_gettokens()
             return 1;
         if (NARGS() == 2 && isstring(objof(f)) && isstring(objof(s)))
         {
-            return fast_gettokens(stringof(f)->s_chars, stringof(s)->s_chars);
+            return fast_gettokens(stringof(f), s->s_chars, s->s_nchars);
         }
         if (isstring(objof(f)))
         {
-            if ((f = ici_sopen(stringof(f)->s_chars, stringof(f)->s_nchars, objof(f))) == NULL)
-                return 1;
-            loose_it = 1;
+            p = stringof(f)->s_chars;
+            e = p + stringof(f)->s_nchars;
         }
         else if (!isfile(objof(f)))
             return ici_argerror(0);
@@ -2577,29 +2628,17 @@ f_gettokens()
             nseps = s->s_nchars;
         }
         else
-        {
-            if (loose_it)
-                ici_decref(f);
             return ici_argerror(1);
-        }
         if (NARGS() > 2)
         {
             if (!isstring(ARG(2)))
-            {
-                if (loose_it)
-                    ici_decref(f);
                 return ici_argerror(2);
-            }
             terms = (unsigned char *)stringof(ARG(2))->s_chars;
             nterms = stringof(ARG(2))->s_nchars;
             if (NARGS() > 3)
             {
                 if (!isstring(ARG(3)))
-                {
-                    if (loose_it)
-                        ici_decref(f);
                     return ici_argerror(3);
-                }
                 delims = (unsigned char *)stringof(ARG(3))->s_chars;
                 ndelims = stringof(ARG(3))->s_nchars;
             }
@@ -2609,8 +2648,16 @@ f_gettokens()
     default:
         return ici_argcount(4);
     }
-    get = f->f_type->ft_getch;
-    file = f->f_file;
+    if (p == NULL)
+    {
+        get = f->f_type->ft_getch;
+        file = f->f_file;
+    }
+    ici_byteset(sepset, (char *)seps, nseps);
+    ici_byteset(termset, (char *)terms, nterms);
+    ici_byteset(delimset, (char *)delims, ndelims);
+    for (i = 0; i < ICI_BYTESETZ; ++i)
+        anyset[i] = sepset[i] | termset[i] | delimset[i];
 
 #define S_IDLE  0
 #define S_INTOK 1
@@ -2626,40 +2673,42 @@ f_gettokens()
         goto fail;
     for (;;)
     {
-        /*
-         * Get the next character and classify it.
-         */
-        if ((c = (*get)(file)) == EOF)
+        if (p != NULL && p < e && !ici_byte_in(anyset, *p))
         {
-            what = W_EOF;
-            goto got_what;
-        }
-        for (i = 0; i < nseps; ++i)
-        {
-            if (c == seps[i])
-            {
-                what = W_SEP;
-                goto got_what;
-            }
-        }
-        for (i = 0; i < nterms; ++i)
-        {
-            if (c == terms[i])
-            {
-                what = W_TERM;
-                goto got_what;
-            }
-        }
-        for (i = 0; i < ndelims; ++i)
-        {
-            if (c == delims[i])
+            /*
+             * Reading from a string and at the start of a run of token
+             * chars.  Take all of them at once.
+             */
+            q = ici_byte_find(p + 1, e, anyset);
+            if (state == S_IDLE)
             {
-                what = W_DELIM;
-                goto got_what;
+                j = 0;
+                state = S_INTOK;
             }
+            if (ici_chkbuf(j + (q - p)))
+                goto fail;
+            memcpy(buf + j, p, q - p);
+            j += q - p;
+            p = q;
         }
-        what = W_TOK;
-    got_what:
+
+        /*
+         * Get the next character and classify it.
+         */
+        if (p != NULL)
+            c = p < e ? *p++ & 0xFF : EOF;
+        else
+            c = (*get)(file);
+        if (c == EOF)
+            what = W_EOF;
+        else if (ici_byte_in(sepset, c))
+            what = W_SEP;
+        else if (ici_byte_in(termset, c))
+            what = W_TERM;
+        else if (ici_byte_in(delimset, c))
+            what = W_DELIM;
+        else
+            what = W_TOK;
 
         /*
          * Act on state and current character classification.
@@ -2667,8 +2716,6 @@ f_gettokens()
         switch ((state << 8) + what)
         {
         case (S_IDLE << 8) + W_EOF:
-            if (loose_it)
-                ici_decref(f);
             if (a->a_top == a->a_base)
             {
                 ici_decref(a);
@@ -2678,11 +2725,7 @@ f_gettokens()
 
         case (S_IDLE << 8) + W_TERM:
             if (!hardsep)
-            {
-                if (loose_it)
-                    ici_decref(f);
                 return ici_ret_with_decref(objof(a));
-            }
             j = 0;
         case (S_INTOK << 8) + W_EOF:
         case (S_INTOK << 8) + W_TERM:
@@ -2691,8 +2734,6 @@ f_gettokens()
             if ((s = ici_str_new(buf, j)) == NULL)
                 goto fail;
             *a->a_top++ = objof(s);
-            if (loose_it)
-                ici_decref(f);
             ici_decref(s);
             return ici_ret_with_decref(objof(a));
 
@@ -2746,8 +2787,6 @@ f_gettokens()
     }
 
 fail:
-    if (loose_it)
-        ici_decref(f);
     if (a != NULL)
         ici_decref(a);
     return 1;
@@ -3106,6 +3145,266 @@ f_sleep()
     return ici_null_ret();
 }
 
+/*
+ * Put everything now in the heap beyond the reach of future garbage
+ * collections.  See ici_gc_freeze().
+ */
+static int
+f_gcfreeze()
+{
+    ici_gc_freeze();
+    return ici_null_ret();
+}
+
+/*
+ * Fetch the number given for the key 'k' of the struct 'o' passed to
+ * gcpolicy(), if there is one, into '*dp'.  It must lie from 'least' to
+ * 'most'.  Returns non-zero on error, usual conventions.
+ */
+static int
+gcpolicy_arg(ici_obj_t *o, ici_obj_t *k, double least, double most, double *dp)
+{
+    ici_obj_t           *v;
+    double              d;
+    char                n[80];
+
+    if ((v = ici_fetch(o, k)) == NULL)
+        return 1;
+    if (isnull(v))
+        return 0;
+    if (ici_fetch_num(o, k, &d))
+        return 1;
+    if (d < least || d > most)
+    {
+        sprintf(n, "a number from %g to %g", least, most);
+        return ici_fetch_mismatch(o, k, v, n);
+    }
+    *dp = d;
+    return 0;
+}
+
+/*
+ * ICI: struct = gcpolicy([struct])
+ *
+ * Return a struct of the settings that govern garbage collection, having
+ * first changed those given in the optional struct argument.  The keys
+ * are growth, minheap, maxheap, cpu, ceiling, pause, threads and
+ * generational.  See ici_gc_growth and the like in object.c.
+ */
+static int
+f_gcpolicy()
+{
+    ici_struct_t        *s;
+    double              growth;
+    double              minheap;
+    double              maxheap;
+    double              cpu;
+    double              ceiling;
+    double              pause;
+    double              threads;
+    double              gen;
+    long                l;
+
+    growth = ici_gc_growth;
+    minheap = ici_gc_min_heap;
+    maxheap = ici_gc_max_heap;
+    cpu = ici_gc_cpu;
+    ceiling = ici_gc_ceiling;
+    pause = ici_gc_pause;
+    threads = ici_gc_threads;
+    gen = !ici_gc_nongenerational;
+    if (NARGS() != 0)
+    {
+        if (ici_typecheck("d", &s))
+            return 1;
+        if
+        (
+               gcpolicy_arg(objof(s), SSO(growth), 1, 1000, &growth)
+            || gcpolicy_arg(objof(s), SSO(minheap), 0, LONG_MAX / 2, &minheap)
+            || gcpolicy_arg(objof(s), SSO(maxheap), 0, LONG_MAX / 2, &maxheap)
+            || gcpolicy_arg(objof(s), SSO(cpu), 0, 1, &cpu)
+            || gcpolicy_arg(objof(s), SSO(ceiling), 0, LONG_MAX / 2, &ceiling)
+            || gcpolicy_arg(objof(s), SSO(pause), 0, 1e9, &pause)
+            || gcpolicy_arg(objof(s), SSO(threads), 0, 64, &threads)
+            || gcpolicy_arg(objof(s), SSO(generational), 0, 1, &gen)
+        )
+            return 1;
+        ici_gc_growth = growth;
+        ici_gc_min_heap = (long)minheap;
+        ici_gc_max_heap = (long)maxheap;
+        ici_gc_cpu = cpu;
+        ici_gc_ceiling = (long)ceiling;
+        ici_gc_pause = (long)pause;
+        ici_gc_threads = (int)threads;
+        ici_gc_nongenerational = gen == 0;
+    }
+    if ((s = ici_struct_new()) == NULL)
+        return 1;
+    if
+    (
+           ici_set_val(objwsupof(s), SS(growth), 'f', &ici_gc_growth)
+        || ici_set_val(objwsupof(s), SS(minheap), 'i', &ici_gc_min_heap)
+        || ici_set_val(objwsupof(s), SS(maxheap), 'i', &ici_gc_max_heap)
+        || ici_set_val(objwsupof(s), SS(cpu), 'f', &ici_gc_cpu)
+        || ici_set_val(objwsupof(s), SS(ceiling), 'i', &ici_gc_ceiling)
+        || ici_set_val(objwsupof(s), SS(pause), 'i', &ici_gc_pause)
+        || ici_set_val(objwsupof(s), SS(threads), 'i', (l = ici_gc_threads, &l))
+        || ici_set_val(objwsupof(s), SS(generational), 'i', (l = !ici_gc_nongenerational, &l))
+    )
+    {
+        ici_decref(s);
+        return 1;
+    }
+    return ici_ret_with_decref(objof(s));
+}
+
+/*
+ * ICI: struct = gcstats()
+ *
+ * Return a struct of statistics of the garbage collector and allocator.
+ * Its types key is a struct, keyed by type name, of structs giving the
+ * objects and bytes of each type in the heap, and its freelists key is an
+ * array of structs giving the size and free blocks of each fast free list.
+ * See ici_gc_stats().
+ */
+static int
+f_gcstats()
+{
+    ici_gcstats_t       gs;
+    ici_struct_t        *s;
+    ici_struct_t        *t;
+    ici_struct_t        *e;
+    ici_array_t         *a;
+    ici_str_t           *n;
+    int                 i;
+
+    ici_gc_stats(&gs);
+    if ((s = ici_struct_new()) == NULL)
+        return 1;
+    if
+    (
+           ici_set_val(objwsupof(s), SS(minors), 'i', &gs.gs_minors)
+        || ici_set_val(objwsupof(s), SS(majors), 'i', &gs.gs_majors)
+        || ici_set_val(objwsupof(s), SS(pausetotal), 'f', &gs.gs_pause_total)
+        || ici_set_val(objwsupof(s), SS(pausemax), 'f', &gs.gs_pause_max)
+        || ici_set_val(objwsupof(s), SS(memused), 'i', &gs.gs_mem_used)
+        || ici_set_val(objwsupof(s), SS(memlimit), 'i', &gs.gs_mem_limit)
+        || ici_set_val(objwsupof(s), SS(objects), 'i', &gs.gs_objects)
+        || ici_set_val(objwsupof(s), SS(frozen), 'i', &gs.gs_frozen)
+        || ici_set_val(objwsupof(s), SS(atoms), 'i', &gs.gs_natoms)
+        || ici_set_val(objwsupof(s), SS(atomsz), 'i', &gs.gs_atomsz)
+        || ici_set_val(objwsupof(s), SS(allocs), 'i', &gs.gs_n_allocs)
+        || ici_set_val(objwsupof(s), SS(allocmem), 'i', &gs.gs_alloc_mem)
+        || ici_set_val(objwsupof(s), SS(runs), 'i', &gs.gs_runs)
+        || ici_set_val(objwsupof(s), SS(idleruns), 'i', &gs.gs_idle_runs)
+    )
+        goto fail;
+
+    if ((t = ici_struct_new()) == NULL)
+        goto fail;
+    i = ici_set_val(objwsupof(s), SS(types), 'o', t);
+    ici_decref(t);
+    if (i)
+        goto fail;
+    for (i = 0; i < ICI_MAX_TYPES; ++i)
+    {
+        if (gs.gs_type_objects[i] == 0 || ici_types[i] == NULL)
+            continue;
+        if ((e = ici_struct_new()) == NULL)
+            goto fail;
+        if ((n = ici_str_new_nul_term(ici_types[i]->t_name)) == NULL)
+        {
+            ici_decref(e);
+            goto fail;
+        }
+        if
+        (
+               ici_set_val(objwsupof(e), SS(objects), 'i', &gs.gs_type_objects[i])
+            || ici_set_val(objwsupof(e), SS(bytes), 'i', &gs.gs_type_bytes[i])
+            || ici_set_val(objwsupof(t), n, 'o', e)
+        )
+        {
+            ici_decref(n);
+            ici_decref(e);
+            goto fail;
+        }
+        ici_decref(n);
+        ici_decref(e);
+    }
+
+    if ((a = ici_array_new(ICI_NFLISTS)) == NULL)
+        goto fail;
+    for (i = 0; i < ICI_NFLISTS && gs.gs_flist_size[i] != 0; ++i)
+    {
+        if ((e = ici_struct_new()) == NULL)
+            goto fail1;
+        *a->a_top++ = objof(e);
+        ici_decref(e);
+        if
+        (
+               ici_set_val(objwsupof(e), SS(size), 'i', &gs.gs_flist_size[i])
+            || ici_set_val(objwsupof(e), SS(free), 'i', &gs.gs_flist_free[i])
+        )
+            goto fail1;
+    }
+    i = ici_set_val(objwsupof(s), SS(freelists), 'o', a);
+    ici_decref(a);
+    if (i)
+        goto fail;
+    return ici_ret_with_decref(objof(s));
+
+fail1:
+    ici_decref(a);
+fail:
+    ici_decref(s);
+    return 1;
+}
+
+/*
+ * ICI: heapdump(file)
+ *
+ * Write a snapshot of the heap to the given file, for heap-report.ici to
+ * read.  See ici_heap_dump().
+ */
+static int
+f_heapdump()
+{
+    ici_file_t          *f;
+
+    if (ici_typecheck("u", &f))
+        return 1;
+    if (ici_heap_dump(f))
+        return 1;
+    return ici_null_ret();
+}
+
+/*
+ * ICI: struct = lookasidestats()
+ *
+ * Return a struct giving the number of struct lookups by name that were
+ * (hits), and weren't (misses), satisfied by the lookup lookaside, and the
+ * number of times all lookasides have been invalidated at once (flushes).
+ */
+static int
+f_lookasidestats()
+{
+    ici_struct_t        *s;
+
+    if ((s = ici_struct_new()) == NULL)
+        return 1;
+    if
+    (
+           ici_set_val(objwsupof(s), SS(hits), 'i', &ici_lookaside_hits)
+        || ici_set_val(objwsupof(s), SS(misses), 'i', &ici_lookaside_misses)
+        || ici_set_val(objwsupof(s), SS(flushes), 'i', &ici_lookaside_flushes)
+    )
+    {
+        ici_decref(s);
+        return 1;
+    }
+    return ici_ret_with_decref(objof(s));
+}
+
 /*
  * Return the accumulated cpu time in seconds as a float. The precision
  * is system dependent. If a float argument is provided, this forms a new
@@ -3249,6 +3548,7 @@ f_which()
     s = NULL;
     if (ici_typecheck(NARGS() < 2 ? "o" : "oo", &k, &s))
         return 1;
+    k = ici_keyof(k);
     if (s == NULL)
         s = objwsupof(ici_vs.a_top[-1]);
     else if (!hassuper(s))
@@ -3258,7 +3558,10 @@ f_which()
         if (isstruct(s))
         {
             if (find_raw_slot(structof(s), k)->sl_key == k)
+            {
+                objof(s)->o_flags &= ~S_FRAME;
                 return ici_ret_no_decref(objof(s));
+            }
         }
         else
         {
@@ -3374,6 +3677,11 @@ ici_cfunc_t std_cfuncs[] =
     {CF_OBJ,    (char *)SS(version),      f_version},
     {CF_OBJ,    (char *)SS(cputime),      f_cputime},
     {CF_OBJ,    (char *)SS(sleep),        f_sleep},
+    {CF_OBJ,    (char *)SS(gcfreeze),     f_gcfreeze},
+    {CF_OBJ,    (char *)SS(gcpolicy),     f_gcpolicy},
+    {CF_OBJ,    (char *)SS(gcstats),      f_gcstats},
+    {CF_OBJ,    (char *)SS(heapdump),     f_heapdump},
+    {CF_OBJ,    (char *)SS(lookasidestats), f_lookasidestats},
     {CF_OBJ,    (char *)SS(strbuf),       f_strbuf},
     {CF_OBJ,    (char *)SS(strcat),       f_strcat},
     {CF_OBJ,    (char *)SS(which),        f_which},
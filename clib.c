@@ -150,6 +150,19 @@ f_getline()
         if ((f = ici_need_stdin()) == NULL)
             return 1;
     }
+    if
+    (
+        (f->f_type == &ici_charbuf_ftype || f->f_type == &ici_strbuf_ftype)
+        &&
+        (objof(f)->o_flags & F_CLOSED) == 0
+    )
+    {
+        ici_obj_t       *o;
+
+        if ((o = ici_charbuf_getline(f)) == NULL)
+            return 1;
+        return ici_ret_with_decref(o);
+    }
     get = f->f_type->ft_getch;
     file = f->f_file;
     if ((b = malloc(buf_size = 128)) == NULL)
@@ -179,7 +192,11 @@ f_getline()
             clearerr(stdin);
         return ici_null_ret();
     }
-    str = ici_str_new(b, i);
+    if ((str = ici_str_alloc(i)) != NULL)
+    {
+        memcpy(str->s_chars, b, i);
+        str = ici_str_lazy(str);
+    }
     free(b);
     if (str == NULL)
         return 1;
@@ -253,7 +270,11 @@ f_getfile()
     }
     if (b == NULL)
         goto nomem;
-    str = ici_str_new(b, i);
+    if ((str = ici_str_alloc(i)) != NULL)
+    {
+        memcpy(str->s_chars, b, i);
+        str = ici_str_lazy(str);
+    }
     free(b);
     goto finish;
 
@@ -3,6 +3,8 @@
 #include "array.h"
 #include "op.h"
 #include "str.h"
+#include "int.h"
+#include "float.h"
 
 /*
  * A cache of binary opperators created by new_binop.
@@ -50,6 +52,119 @@ new_binop(int op, int why)
     return o;
 }
 
+/*
+ * Set this non-zero to stop compile_expr() folding constant expressions and
+ * fusing simple binary operations (the -O0 command line option).  So the
+ * two can be compared.
+ */
+int     ici_dont_optimize;
+
+/*
+ * Called by compile_expr() when the code for the operands of the binary
+ * operator op (a token) runs from start to the top of a, just before the
+ * operator itself is added.  If both operands are just constant ints, floats
+ * or strings, the operation is done now and they are replaced by its result.
+ * If it fails (as "a" * 2 will) it is left to fail at run time.  If they are
+ * just names or numbers, o_quickbinop is put before them so that they can be
+ * fetched and the operation done together (see OP_QUICKBINOP in exec.c).
+ *
+ * Returns 1 if the operator is no longer needed, 0 if it is, and -1 on
+ * error, usual conventions.
+ */
+static int
+optimize_binop(ici_array_t *a, ptrdiff_t start, int op)
+{
+    ici_obj_t           **p;
+    ici_obj_t           *o;
+    ici_array_t         *a1;
+    int                 n;
+
+    for (n = 0, p = a->a_base + start; p < a->a_top; ++n)
+    {
+        if (*p == objof(&o_quote) && p + 1 < a->a_top && isstring(p[1]))
+            p += 2;
+        else if (isint(*p) || isfloat(*p))
+            ++p;
+        else
+            break;
+    }
+    if (n == 2 && p == a->a_top && !ici_debug_active)
+    {
+        if ((a1 = ici_array_new(6)) == NULL)
+            return -1;
+        for (p = a->a_base + start; p < a->a_top; ++p)
+            *a1->a_top++ = *p;
+        if ((*a1->a_top = new_binop(op, FOR_VALUE)) == NULL)
+        {
+            ici_decref(a1);
+            return -1;
+        }
+        ++a1->a_top;
+        *a1->a_top++ = objof(&o_end);
+        o = ici_evaluate(objof(a1), 0);
+        ici_decref(a1);
+        if (o == NULL)
+        {
+            ici_error = NULL;
+            return 0;
+        }
+        a->a_top = a->a_base + start;
+        if (isstring(o))
+            *a->a_top++ = objof(&o_quote);
+        ici_wb(a);
+        *a->a_top++ = o;
+        ici_decref(o);
+        return 1;
+    }
+    if (a->a_top - a->a_base != start + 2)
+        return 0;
+    p = a->a_base + start;
+    if
+    (
+        !(isstring(p[0]) || isint(p[0]) || isfloat(p[0]))
+        ||
+        !(isstring(p[1]) || isint(p[1]) || isfloat(p[1]))
+        ||
+        !(isstring(p[0]) || isstring(p[1]))
+    )
+        return 0;
+    if (ici_stk_push_chk(a, 2))
+        return -1;
+    p = a->a_base + start;
+    p[2] = p[1];
+    p[1] = p[0];
+    p[0] = objof(&o_quickbinop);
+    ++a->a_top;
+    return 0;
+}
+
+/*
+ * Add the op 'op' to the code array 'a', followed by a new inline cache (see
+ * ici_icache_t) for the key given by the constant string expression 'e'.
+ * Returns 1 on failure, 0 on success.
+ */
+static int
+compile_icached(ici_array_t *a, ici_op_t *op, expr_t *e)
+{
+    ici_icache_t        *ic;
+
+    if (ici_stk_push_chk(a, 2))
+        return 1;
+    if ((ic = ici_icache_new(stringof(e->e_obj))) == NULL)
+        return 1;
+    *a->a_top++ = objof(op);
+    ici_wb(a);
+    *a->a_top++ = objof(ic);
+    ici_decref(ic);
+    return 0;
+}
+
+/*
+ * Whether the expression 'e', the key of a . or :, can have an inline
+ * cache.
+ */
+#define ICACHEABLE(e)   (!ici_dont_optimize && (e)->e_what == T_STRING && isstring((e)->e_obj))
+
 /*
  * Compile the expression into the code array, for the reason given.
  * Returns 1 on failure, 0 on success.
@@ -57,6 +172,8 @@ new_binop(int op, int why)
 int
 compile_expr(ici_array_t *a, expr_t *e, int why)
 {
+    ptrdiff_t           start;  /* Where the code for e begins in a. */
+    int                 rc;
 
 #define NOTLV(why)      ((why) == FOR_LVALUE ? FOR_VALUE : (why))
 #define NOTTEMP(why)    ((why) == FOR_TEMP ? FOR_VALUE : (why))
@@ -113,6 +230,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             }
             *a2->a_top++ = objof(&o_end);
             *a->a_top++ = objof(&o_ifelse);
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             *a->a_top++ = objof(a2);
             ici_decref(a1);
@@ -130,6 +248,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             if ((*a->a_top = objof(new_op(NULL, OP_SWAP, NOTTEMP(why)))) == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             a->a_top++;
             return 0;
         }
@@ -143,6 +262,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 if (ici_stk_push_chk(a, 2))
                     return 1;
                 *a->a_top++ = objof(&o_quote);
+                ici_wb(a);
                 *a->a_top++ = e->e_arg[0]->e_obj;
                 if (compile_expr(a, e->e_arg[1], FOR_VALUE))
                     return 1;
@@ -151,6 +271,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 if ((*a->a_top = objof(new_op(NULL, OP_ASSIGNLOCALVAR, NOTTEMP(why)))) == NULL)
                     return 1;
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 a->a_top++;
                 return 0;
             }
@@ -163,6 +284,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 if ((*a->a_top = objof(new_op(NULL, OP_ASSIGN_TO_NAME, NOTTEMP(why)))) == NULL)
                     return 1;
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 ++a->a_top;
                 *a->a_top++ = e->e_arg[0]->e_obj;
                 return 0;
@@ -177,6 +299,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 e->e_what == T_EQ ? OP_ASSIGN : OP_ASSIGNLOCAL, NOTTEMP(why)))) == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             a->a_top++;
             return 0;
         }
@@ -196,10 +319,12 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 return 1;
             if ((*a->a_top = new_binop(e->e_what, FOR_VALUE)) == NULL)
                 return 1;
+            ici_wb(a);
             ++a->a_top;
             if ((*a->a_top = objof(new_op(NULL, OP_ASSIGN, NOTTEMP(why)))) == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             a->a_top++;
             return 0;
         }
@@ -226,6 +351,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 return 1;
             }
             *a1->a_top++ = objof(&o_end);
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             *a->a_top++ = objof(e->e_what == T_ANDAND ? &o_andand : &o_barbar);
@@ -237,16 +363,20 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
          * Ordinary binary op. All binary operators that take an int or a float
          * on either side can take a temp.
          */
+        start = a->a_top - a->a_base;
         if (compile_expr(a, e->e_arg[0], why == FOR_VALUE ? FOR_TEMP : why))
             return 1;
         if (compile_expr(a, e->e_arg[1], why == FOR_VALUE ? FOR_TEMP : why))
             return 1;
-        if (ici_stk_push_chk(a, 1))
-            return 1;
         if (why == FOR_EFFECT)
             return 0;
+        if (!ici_dont_optimize && (rc = optimize_binop(a, start, e->e_what)) != 0)
+            return rc < 0;
+        if (ici_stk_push_chk(a, 1))
+            return 1;
         if ((*a->a_top = new_binop(e->e_what, why)) == NULL)
             return 1;
+        ici_wb(a);
         ++a->a_top;
         return 0;
     }
@@ -299,6 +429,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             {
                 if (isstring(e->e_obj))
                     *a->a_top++ = objof(&o_quote);
+                ici_wb(a);
                 *a->a_top++ = e->e_obj;
             }
             break;
@@ -306,6 +437,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
         case T_NAME:
             if (why == FOR_LVALUE)
                 *a->a_top++ = objof(&o_namelvalue);
+            ici_wb(a);
             *a->a_top++ = e->e_obj;
             if (why == FOR_EFFECT)
             {
@@ -341,10 +473,12 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 *a->a_top++ = objof(ici_one);
                 if ((*a->a_top = new_binop(e->e_what == T_PLUSPLUS ? T_PLUS : T_MINUS, FOR_VALUE)) == NULL)
                     return 1;
+                ici_wb(a);
                 ++a->a_top;
                 if ((*a->a_top = objof(new_op(NULL, OP_ASSIGN, FOR_EFFECT))) == NULL)
                     return 1;
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 a->a_top++;
             }
             else
@@ -361,10 +495,12 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 *a->a_top++ = objof(ici_one);
                 if ((*a->a_top = new_binop(e->e_what == T_PLUSPLUS ? T_PLUS : T_MINUS, FOR_VALUE)) == NULL)
                     return 1;
+                ici_wb(a);
                 ++a->a_top;
                 if ((*a->a_top = objof(new_op(NULL, OP_ASSIGN, NOTTEMP(why)))) == NULL)
                     return 1;
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 a->a_top++;
                 return 0;
             }
@@ -377,13 +513,21 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
              */
             if (why == FOR_EFFECT)
                 return compile_expr(a, e->e_arg[0], FOR_EFFECT);
+            start = a->a_top - a->a_base;
             *a->a_top++ = objof(ici_zero);
-            if (compile_expr(a, e->e_arg[0], NOTLV(why)))
+            if (compile_expr(a, e->e_arg[0], why == FOR_VALUE ? FOR_TEMP : NOTLV(why)))
                 return 1;
+            if (!ici_dont_optimize && (rc = optimize_binop(a, start, e->e_what)) != 0)
+            {
+                if (rc < 0)
+                    return 1;
+                break;
+            }
             if (ici_stk_push_chk(a, 1))
                 return 1;
             if ((*a->a_top = new_binop(e->e_what, why)) == NULL)
                 break;
+            ici_wb(a);
             ++a->a_top;
             break;
 
@@ -402,6 +546,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             if ((*a->a_top = objof(new_op(ici_op_unary, 0, t_subtype(e->e_what)))) == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             ++a->a_top;
             break;
 
@@ -415,6 +560,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             if ((*a->a_top = objof(new_op(NULL, OP_AT, 0))) == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             ++a->a_top;
             break;
 
@@ -482,6 +628,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             if (*a->a_top == NULL)
                 return 1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             a->a_top++;
             break;
 
@@ -499,6 +646,12 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
             if (compile_expr(a, e->e_arg[0], why != FOR_EFFECT ? FOR_VALUE : why))
                 return 1;
         dot2:
+            if (why != FOR_EFFECT && why != FOR_LVALUE && ICACHEABLE(e->e_arg[1]))
+            {
+                if (compile_icached(a, &o_icdot, e->e_arg[1]))
+                    return 1;
+                break;
+            }
             if (compile_expr(a, e->e_arg[1], why != FOR_EFFECT ? FOR_VALUE : why))
                 return 1;
             if (why == FOR_EFFECT)
@@ -545,6 +698,7 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                 if ((*a->a_top = objof(ici_int_new(nargs))) == NULL)
                     return 1;
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 ++a->a_top;
                 if
                 (
@@ -563,6 +717,21 @@ compile_expr(ici_array_t *a, expr_t *e, int why)
                      */
                     if (compile_expr(a, e->e_arg[0]->e_arg[0], FOR_VALUE))
                         return 1;
+                    if
+                    (
+                        e->e_arg[0]->e_what == T_PRIMARYCOLON
+                        &&
+                        ICACHEABLE(e->e_arg[0]->e_arg[1])
+                    )
+                    {
+                        if (compile_icached(a, &o_icmethod_call, e->e_arg[0]->e_arg[1]))
+                            return 1;
+                        if (ici_stk_push_chk(a, 1))
+                            return 1;
+                        if (why == FOR_EFFECT)
+                            *a->a_top++ = objof(&o_pop);
+                        break;
+                    }
                     if (compile_expr(a, e->e_arg[0]->e_arg[1], FOR_VALUE))
                         return 1;
                     if (ici_stk_push_chk(a, 2))
@@ -31,6 +31,9 @@
 #define ICI_USE_POSIX_THREADS
 #endif
 
+#define ICI_USE_MADVISE         /* Give free memory back, see alloc.c. */
+#define ICI_USE_THREADED_CODE   /* Dispatch ops by computed goto, see exec.c. */
+
 #if defined(__FreeBSD__) && (__FreeBSD__ < 3)
 /*
  * Pre-3.0 FreeBSD uses a.out format objects that appends a leading "_"
@@ -26,6 +26,8 @@
  */
 
 #define ICI_USE_POSIX_THREADS
+#define ICI_USE_MADVISE         /* Give free memory back, see alloc.c. */
+#define ICI_USE_THREADED_CODE   /* Dispatch ops by computed goto, see exec.c. */
 #define pthread_mutexattr_settype pthread_mutexattr_setkind_np
 #define PTHREAD_MUTEX_RECURSIVE PTHREAD_MUTEX_RECURSIVE_NP
 
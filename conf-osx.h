@@ -30,6 +30,8 @@
 #define ICI_DLL_EXT     ".bundle"
 
 #define ICI_USE_POSIX_THREADS
+#define ICI_USE_MADVISE         /* Give free memory back, see alloc.c. */
+#define ICI_USE_THREADED_CODE   /* Dispatch ops by computed goto, see exec.c. */
 
 #include <crt_externs.h>
 #define environ *_NSGetEnviron()
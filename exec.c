@@ -69,6 +69,25 @@ ici_int_t       *ici_one;
  */
 volatile int    ici_aborted;
 
+/*
+ * With GCC (and compilers like it) ops can be dispatched by jumping
+ * straight to the code for each through a table of label addresses, rather
+ * than by the switch on op_ecode.  See ici_evaluate().
+ */
+#if defined(ICI_USE_THREADED_CODE) && defined(__GNUC__)
+#define THREADED_CODE
+#endif
+
+/*
+ * GCC will otherwise merge the identical ends of the cases, so that they
+ * all share one indirect jump again and nothing is gained.
+ */
+#if defined(THREADED_CODE) && !defined(__clang__)
+#define EVALUATE_ATTRS  __attribute__((optimize("no-crossjumping")))
+#else
+#define EVALUATE_ATTRS
+#endif
+
 #ifndef NOSIGNALS
 # ifdef SUNOS5
 int sigisempty(sigset_t *s) {
@@ -279,6 +298,67 @@ get_pc(ici_array_t *code, ici_obj_t **xs)
     pc->pc_next = code->a_base;
 }
 
+/*
+ * The string the error variable was last set to when an error was caught,
+ * or that fail() was last given.  If the message of the next error caught
+ * is the same, as it usually is when errors are being used for control
+ * flow, this is used again rather than making and atomizing the string
+ * over.  We hold a reference to it.
+ */
+ici_str_t       *ici_error_str;
+
+/*
+ * Make the atomic string 's' the one that will be used for the error
+ * variable if the next error caught has its message.
+ */
+void
+ici_set_error_str(ici_str_t *s)
+{
+    ici_incref(s);
+    if (ici_error_str != NULL)
+        ici_decref(ici_error_str);
+    ici_error_str = s;
+}
+
+/*
+ * Set x_src to the source marker of what is being done, from the innermost
+ * code with line information that is running on the execution stack below
+ * 'xt'.  Most code keeps its source markers in a line table rather than
+ * among the code (see ici_src_table()), so x_src is not kept up to date as
+ * it runs, and anything that wants it must call this first.  If nothing is
+ * found, x_src is left as it is.
+ */
+void
+ici_set_src(ici_obj_t **xt)
+{
+    ici_obj_t           **p;
+    ici_src_t           *s;
+    int                 line;
+
+    for (p = xt - 1; p >= ici_xs.a_base; --p)
+    {
+        if (!ispc(*p))
+            continue;
+        s = ici_src_find
+        (
+            pcof(*p)->pc_code,
+            pcof(*p)->pc_next - pcof(*p)->pc_code->a_bot - 1,
+            &line
+        );
+        if (s == NULL)
+            continue;
+        if (s->s_lineno != line)
+        {
+            if ((s = new_src(line, s->s_filename)) == NULL)
+                return;
+            ici_decref(s);
+        }
+        ici_exec->x_src = s;
+        ici_wb(ici_exec);
+        return;
+    }
+}
+
 /*
  * Execute 'code' (any object, normally an ici_array_t of code or a
  * ici_parse_t).  The execution procedes on top of the current stacks
@@ -307,8 +387,18 @@ get_pc(ici_array_t *code, ici_obj_t **xs)
  * removed, apart from the fail exits.  Then one got added again.  And again.
  *
  * Note that binop.h is included half way down this function.
+ *
+ * Each case below ends by going on to the next thing to execute with one of
+ * the macros NEXT() (the usual way round the loop), NEXT_STABLE() (stacks
+ * known not to have grown, see stable_stacks_continue) or NEXT_SAME_PC()
+ * (the pc known to still be on top of the execution stack).  Normally these
+ * are just a continue or goto.  With THREADED_CODE, they fetch the next
+ * thing from the pc themselves and, if it is an op, jump straight to its
+ * case through op_labels[].  So each op has its own indirect branch to the
+ * next, which the processor's branch prediction does much better with than
+ * the one shared switch.
  */
-ici_obj_t *
+EVALUATE_ATTRS ici_obj_t *
 ici_evaluate(ici_obj_t *code, int n_operands)
 {
     register ici_obj_t  *o;
@@ -316,13 +406,95 @@ ici_evaluate(ici_obj_t *code, int n_operands)
     int                 flags;
     ici_catch_t         frame;
     ici_src_t           *src;
+    ici_obj_t           **xt;   /* Execution stack top at last error. */
 #define FETCH(s, k) \
                         isstring(objof(k)) \
                             && stringof(k)->s_struct == structof(s) \
-                            && stringof(k)->s_vsver == ici_vsver \
-                        ? stringof(k)->s_slot->sl_value \
+                            && isstruct(s) \
+                            && stringof(k)->s_vsver == structof(s)->s_vsver \
+                        ? (++ici_lookaside_hits, ici_fetched(stringof(k)->s_slot->sl_value)) \
                         : ici_fetch(s, k)
+#ifndef NOSIGNALS
+#define CHECK_SIGNALS() do { \
+                            if (sigisempty(&ici_signals_pending)) \
+                                ici_signals_invoke_handlers(); \
+                        } while (0)
+#else
+#define CHECK_SIGNALS() do {} while (0)
+#endif
+#ifdef THREADED_CODE
+#define OP_CASE(x)      case x: lab_##x
+#define NEXT_SAME_PC()  do { \
+                            o = *pcof(pc)->pc_next++; \
+                            if (isop(o)) \
+                                goto *op_labels[opof(o)->op_ecode]; \
+                            goto not_an_op; \
+                        } while (0)
+#define NEXT_STABLE()   do { \
+                            CHECK_SIGNALS(); \
+                            if (ispc(pc = ici_xs.a_top[-1])) \
+                                NEXT_SAME_PC(); \
+                            goto stable_stacks_continue; \
+                        } while (0)
+#define NEXT()          do { \
+                            if (--ici_exec_count == 0) \
+                                goto count_expired; \
+                            NEXT_STABLE(); \
+                        } while (0)
+    /*
+     * Indexed by op_ecode, so in the order of the OP_* enum in op.h.
+     */
+    static void         *op_labels[] =
+    {
+        &&lab_OP_OTHER,
+        &&lab_OP_CALL,
+        &&lab_OP_NAMELVALUE,
+        &&lab_OP_DOT,
+        &&lab_OP_DOTKEEP,
+        &&lab_OP_DOTRKEEP,
+        &&lab_OP_ASSIGN,
+        &&lab_OP_ASSIGN_TO_NAME,
+        &&lab_OP_ASSIGNLOCAL,
+        &&lab_OP_EXEC,
+        &&lab_OP_LOOP,
+        &&lab_OP_REWIND,
+        &&lab_OP_ENDCODE,
+        &&lab_OP_IF,
+        &&lab_OP_IFELSE,
+        &&lab_OP_IFNOTBREAK,
+        &&lab_OP_IFBREAK,
+        &&lab_OP_BREAK,
+        &&lab_OP_QUOTE,
+        &&lab_OP_BINOP,
+        &&lab_OP_AT,
+        &&lab_OP_SWAP,
+        &&lab_OP_BINOP_FOR_TEMP,
+        &&bad_op,               /* OP_AGGR_KEY_CALL */
+        &&lab_OP_COLON,
+        &&bad_op,               /* OP_COLONCARET */
+        &&lab_OP_METHOD_CALL,
+        &&lab_OP_SUPER_CALL,
+        &&lab_OP_ASSIGNLOCALVAR,
+        &&lab_OP_CRITSECT,
+        &&lab_OP_WAITFOR,
+        &&lab_OP_POP,
+        &&lab_OP_CONTINUE,
+        &&lab_OP_LOOPER,
+        &&lab_OP_ANDAND,
+        &&lab_OP_SWITCH,
+        &&lab_OP_SWITCHER,
+        &&lab_OP_QUICKBINOP,
+        &&lab_OP_ICDOT,
+        &&lab_OP_ICMETHOD_CALL,
+    };
+#else
+#define OP_CASE(x)      case x
+#define NEXT_SAME_PC()  goto continue_with_same_pc
+#define NEXT_STABLE()   goto stable_stacks_continue
+#define NEXT()          continue
+#endif
 
+    xt = ici_xs.a_top;
     if (++ici_exec->x_n_engine_recurse > 50)
     {
         ici_error = "excessive recursive invocations of the main interpreter";
@@ -362,6 +534,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
     {
         if (--ici_exec_count == 0)
         {
+#ifdef THREADED_CODE
+        count_expired:
+#endif
             if (ici_aborted)
             {
                 ici_error = "aborted";
@@ -405,17 +580,18 @@ ici_evaluate(ici_obj_t *code, int n_operands)
          * indirecting the pc is not a pc, so there is no general case
          * in the switch.
          */
-#ifndef NOSIGNALS
-        if (sigisempty(&ici_signals_pending))
-            ici_signals_invoke_handlers();
-#endif
+        CHECK_SIGNALS();
         assert(ici_os.a_top >= ici_os.a_base);
         if (ispc(pc = ici_xs.a_top[-1]))
         {
+#ifdef THREADED_CODE
+            NEXT_SAME_PC();
+#else
     continue_with_same_pc:
             o = *pcof(pc)->pc_next++;
             if (isop(o))
                 goto an_op;
+#endif
         }
         else
         {
@@ -433,6 +609,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
          * the formal model. The code just above here assumes this, but
          * has to explicitly pop the stack in the non-pc case.
          */
+#ifdef THREADED_CODE
+    not_an_op:
+#endif
         switch (o->o_tcode)
         {
         case TC_SRC:
@@ -442,15 +621,15 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 *ici_xs.a_top++ = o; /* Restore formal state. */
                 ici_debug->idbg_src(srcof(o));
                 --ici_xs.a_top;
-                continue;
+                NEXT();
             }
-            goto stable_stacks_continue;
+            NEXT_STABLE();
 
         case TC_PARSE:
             *ici_xs.a_top++ = o; /* Restore formal state. */
             if (parse_exec())
                 goto fail;
-            continue;
+            NEXT();
 
         case TC_STRING:
             /*
@@ -465,7 +644,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
             (
                 stringof(o)->s_struct == structof(ici_vs.a_top[-1])
                 &&
-                stringof(o)->s_vsver == ici_vsver
+                stringof(o)->s_vsver == structof(ici_vs.a_top[-1])->s_vsver
             )
             {
                 /*
@@ -475,12 +654,15 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                  */
                 assert(ici_fetch_super(ici_vs.a_top[-1], o, ici_os.a_top, NULL) == 1);
                 assert(*ici_os.a_top == stringof(o)->s_slot->sl_value);
-                *ici_os.a_top++ = stringof(o)->s_slot->sl_value;
+                *ici_os.a_top++ = ici_fetched(stringof(o)->s_slot->sl_value);
+                ++ici_lookaside_hits;
             }
             else
             {
                 ici_obj_t   *f;
 
+                ++ici_lookaside_misses;
+
                 /*
                  * This is an in-line version of fetch_struct because
                  * (a) we know that the top of the variable stack is
@@ -551,7 +733,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 }
                 ++ici_os.a_top;
             }
-            continue;
+            NEXT();
 
         case TC_CATCH:
             /*
@@ -592,37 +774,39 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 ici_exec_count = 1;
             }
             ici_unwind();
-            goto stable_stacks_continue;
+            NEXT_STABLE();
 
         case TC_FORALL:
             *ici_xs.a_top++ = o; /* Restore formal state. */
             if (exec_forall())
                 goto fail;
-            continue;
+            NEXT();
 
         default:
             *ici_os.a_top++ = o;
-            continue;
+            NEXT();
 
         case TC_OP:
+#ifndef THREADED_CODE
         an_op:
+#endif
             switch (opof(o)->op_ecode)
             {
-            case OP_OTHER:
+            OP_CASE(OP_OTHER):
                 *ici_xs.a_top++ = o; /* Restore to formal state. */
                 if ((*opof(o)->op_func)())
                     goto fail;
-                continue;
+                NEXT();
 
-            case OP_SUPER_CALL:
+            OP_CASE(OP_SUPER_CALL):
                 flags = OPC_COLON_CALL | OPC_COLON_CARET;
                 goto do_colon;
 
-            case OP_METHOD_CALL:
+            OP_CASE(OP_METHOD_CALL):
                 flags = OPC_COLON_CALL;
                 goto do_colon;
 
-            case OP_COLON:
+            OP_CASE(OP_COLON):
                 /*
                  * aggr key => method (os) (normal case)
                  */
@@ -670,7 +854,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                         --ici_os.a_top;
                         ici_os.a_top[-1] = objof(m);
                         ici_decref(m);
-                        goto stable_stacks_continue;
+                        NEXT_STABLE();
                     }
                     /*
                      * This is a direct call, don't form the method object.
@@ -684,7 +868,33 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     goto do_call;
                 }
 
-            case OP_CALL:
+            OP_CASE(OP_ICMETHOD_CALL):
+                /*
+                 * subject => callable (os), and call it as OP_METHOD_CALL
+                 * does.  The key, and an inline cache for it, are next in
+                 * the code.
+                 */
+                {
+                    ici_icache_t        *ic;
+                    ici_obj_t           *s;
+                    ici_obj_t           *f;
+
+                    ic = icacheof(*pcof(ici_xs.a_top[-1])->pc_next++);
+                    s = ici_os.a_top[-1];
+                    if (ici_typeof(s)->t_fetch_method != NULL)
+                        f = (*ici_typeof(s)->t_fetch_method)(s, objof(ic->ic_key));
+                    else
+                        f = ici_fetch_icached(ic, s);
+                    if (f == NULL)
+                        goto fail;
+                    *ici_xs.a_top++ = o;    /* Restore xs to formal state. */
+                    ici_os.a_top[-1] = f;   /* The callable object. */
+                    o = s;
+                    ici_incref(o);
+                    goto do_call;
+                }
+
+            OP_CASE(OP_CALL):
                 *ici_xs.a_top++ = o;        /* Restore to formal state. */
                 o = NULL;                   /* No subject object. */
             do_call:
@@ -700,6 +910,8 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 }
                 if (ici_debug_active)
                     ici_debug->idbg_fncall(ici_os.a_top[-1], ARGS(), NARGS());
+                if ((opof(ici_xs.a_top[-1])->op_code & OPC_TAIL_CALL) && isfunc(ici_os.a_top[-1]))
+                    ici_tail_call_frame();
                 if ((*ici_typeof(ici_os.a_top[-1])->t_call)(ici_os.a_top[-1], o))
                 {
                     if (o != NULL)
@@ -708,25 +920,25 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 }
                 if (o != NULL)
                     ici_decref(o);
-                continue;
+                NEXT();
 
-            case OP_QUOTE:
+            OP_CASE(OP_QUOTE):
                 /*
                  * pc           => pc+1 (xs)
                  *              => *pc (os)
                  */
                 o = ici_xs.a_top[-1];
                 *ici_os.a_top++ = *pcof(o)->pc_next++;
-                continue;
+                NEXT();
 
-            case OP_AT:
+            OP_CASE(OP_AT):
                 /*
                  * obj => obj (os)
                  */
                 ici_os.a_top[-1] = ici_atom(ici_os.a_top[-1], 0);
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_NAMELVALUE:
+            OP_CASE(OP_NAMELVALUE):
                 /*
                  * pc (xs)      => pc+1 (xs)
                  *              => struct *pc (os)
@@ -735,9 +947,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                  */
                 *ici_os.a_top++ = ici_vs.a_top[-1];
                 *ici_os.a_top++ = *pcof(ici_xs.a_top[-1])->pc_next++;
-                continue;
+                NEXT();
 
-            case OP_DOT:
+            OP_CASE(OP_DOT):
                 /*
                  * aggr key => value (os)
                  */
@@ -745,18 +957,45 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     goto fail;
                 --ici_os.a_top;
                 ici_os.a_top[-1] = o;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_DOTKEEP:
+            OP_CASE(OP_ICDOT):
                 /*
-                 * aggr key => aggr key value (os)
+                 * aggr => value (os)
+                 *
+                 * The key, and an inline cache for it, are next in the code.
                  */
-                if ((o = FETCH(ici_os.a_top[-2], ici_os.a_top[-1])) == NULL)
+                o = *pcof(ici_xs.a_top[-1])->pc_next++;
+                if ((o = ici_fetch_icached(icacheof(o), ici_os.a_top[-1])) == NULL)
                     goto fail;
+                ici_os.a_top[-1] = o;
+                NEXT_STABLE();
+
+            OP_CASE(OP_DOTKEEP):
+                /*
+                 * aggr key => aggr key value (os)
+                 *
+                 * This is for an assignment op, which replaces the value
+                 * with one it makes.  So fetching it from a struct here
+                 * doesn't lose ici_str_tip, unless another assignment op
+                 * that fetched it is still to finish (see ici_str_append()).
+                 */
+                {
+                    ici_str_t   *tip;
+
+                    tip = ici_str_tip;
+                    if ((o = FETCH(ici_os.a_top[-2], ici_os.a_top[-1])) == NULL)
+                        goto fail;
+                    if (o == objof(tip) && isstruct(ici_os.a_top[-2]) && !ici_str_tip_kept)
+                    {
+                        ici_str_tip = tip;
+                        ici_str_tip_kept = 1;
+                    }
+                }
                 *ici_os.a_top++ = o;
-                continue;
+                NEXT();
 
-            case OP_DOTRKEEP:
+            OP_CASE(OP_DOTRKEEP):
                 /*
                  * aggr key => value aggr key value (os)
                  *
@@ -769,9 +1008,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 ici_os.a_top[-2] = ici_os.a_top[-3];
                 ici_os.a_top[-3] = ici_os.a_top[-4];
                 ici_os.a_top[-4] = o;
-                continue;
+                NEXT();
 
-            case OP_ASSIGNLOCALVAR:
+            OP_CASE(OP_ASSIGNLOCALVAR):
                 /*
                  * name value => - (os, for effect)
                  *                => value (os, for value)
@@ -795,9 +1034,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     ici_os.a_top[-2] = ici_vs.a_top[-1];
                     break;
                 }
-                continue;
+                NEXT();
 
-            case OP_ASSIGN_TO_NAME:
+            OP_CASE(OP_ASSIGN_TO_NAME):
                 /*
                  * value on os, next item in code is name.
                  */
@@ -806,7 +1045,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 ici_os.a_top[-2] = *pcof(ici_xs.a_top[-1])->pc_next++;
                 ici_os.a_top[-3] = ici_vs.a_top[-1];
                 /* Fall through. */
-            case OP_ASSIGN:
+            OP_CASE(OP_ASSIGN):
                 /*
                  * aggr key value => - (os, for effect)
                  *                => value (os, for value)
@@ -814,23 +1053,31 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                  */
                 if
                 (
+                    isstring(ici_os.a_top[-2])
+                    &&
                     stringof(ici_os.a_top[-2])->s_struct == structof(ici_os.a_top[-3])
                     &&
-                    stringof(ici_os.a_top[-2])->s_vsver == ici_vsver
+                    isstruct(ici_os.a_top[-3])
                     &&
-                    isstring(ici_os.a_top[-2])
+                    stringof(ici_os.a_top[-2])->s_vsver == structof(ici_os.a_top[-3])->s_vsver
                     &&
                     (objof(ici_os.a_top[-2])->o_flags & S_LOOKASIDE_IS_ATOM) == 0
                 )
                 {
+                    ici_struct_wb_slot
+                    (
+                        structof(ici_os.a_top[-3]),
+                        stringof(ici_os.a_top[-2])->s_slot
+                    );
                     stringof(ici_os.a_top[-2])->s_slot->sl_value = ici_os.a_top[-1];
+                    ++ici_lookaside_hits;
                     goto assign_finish;
                 }
                 if (ici_assign(ici_os.a_top[-3], ici_os.a_top[-2], ici_os.a_top[-1]))
                     goto fail;
                 goto assign_finish;
 
-            case OP_ASSIGNLOCAL:
+            OP_CASE(OP_ASSIGNLOCAL):
                 /*
                  * aggr key value => - (os, for effect)
                  *                => value (os, for value)
@@ -854,7 +1101,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     break;
 
                 case FOR_VALUE:
-                    ici_os.a_top[-3] = ici_os.a_top[-1];
+                    ici_os.a_top[-3] = ici_fetched(ici_os.a_top[-1]);
                     ici_os.a_top -= 2;
                     break;
 
@@ -862,9 +1109,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     --ici_os.a_top;
                     break;
                 }
-                continue;
+                NEXT();
 
-            case OP_SWAP:
+            OP_CASE(OP_SWAP):
                 /*
                  * aggr1 key1 aggr2 key2        =>
                  *                              => value1
@@ -913,9 +1160,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     ici_decref(v1);
                     ici_decref(v2);
                 }
-                continue;
+                NEXT();
 
-            case OP_IF:
+            OP_CASE(OP_IF):
                 /*
                  * bool => - (os)
                  *
@@ -924,15 +1171,15 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 {
                     --ici_os.a_top;
                     ++pcof(ici_xs.a_top[-1])->pc_next;
-                    goto stable_stacks_continue;
+                    NEXT_STABLE();
                 }
                 o = *pcof(ici_xs.a_top[-1])->pc_next++;
                 get_pc(arrayof(o), ici_xs.a_top);
                 --ici_os.a_top;
                 ++ici_xs.a_top;
-                continue;
+                NEXT();
 
-            case OP_IFELSE:
+            OP_CASE(OP_IFELSE):
                 /*
                  * bool => -
                  */
@@ -949,9 +1196,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 get_pc(arrayof(o), ici_xs.a_top);
                 --ici_os.a_top;
                 ++ici_xs.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_IFBREAK:
+            OP_CASE(OP_IFBREAK):
                 /*
                  * bool => - (os)
                  *      => [o_break] (xs)
@@ -959,12 +1206,12 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 if (isfalse(ici_os.a_top[-1]))
                 {
                     --ici_os.a_top;
-                    continue;
+                    NEXT();
                 }
                 --ici_os.a_top;
                 goto do_break;
 
-             case OP_IFNOTBREAK:
+            OP_CASE(OP_IFNOTBREAK):
                 /*
                  * bool => - (os)
                  *      => [o_break] (xs)
@@ -972,11 +1219,11 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 if (!isfalse(ici_os.a_top[-1]))
                 {
                     --ici_os.a_top;
-                    continue;
+                    NEXT();
                 }
                 --ici_os.a_top;
                 /* Falling through. */
-            case OP_BREAK:
+            OP_CASE(OP_BREAK):
             do_break:
                 /*
                  * Pop the execution stack until a looper or switcher
@@ -1007,19 +1254,19 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                         )
                         {
                             ici_xs.a_top = s - 2;
-                            goto stable_stacks_continue;
+                            NEXT_STABLE();
                         }
                         else if (isforall(s[-1]))
                         {
                             ici_xs.a_top = s - 1;
-                            goto stable_stacks_continue;
+                            NEXT_STABLE();
                         }
                     }
                 }
                 ici_error = "break not within loop or switch";
                 goto fail;
 
-            case OP_ANDAND:
+            OP_CASE(OP_ANDAND):
                 /*
                  * bool obj => bool (os) OR pc (xs)
                  */
@@ -1034,7 +1281,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                         get_pc(arrayof(ici_os.a_top[-1]), ici_xs.a_top);
                         ++ici_xs.a_top;
                         ici_os.a_top -= 2;
-                        goto stable_stacks_continue;
+                        NEXT_STABLE();
                     }
                     /*
                      * This is the old behaviour of ICI 4.0.3 and before
@@ -1044,9 +1291,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                      */
                     --ici_os.a_top;
                 }
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_CONTINUE:
+            OP_CASE(OP_CONTINUE):
                 /*
                  * Pop the execution stack until a looper is found.
                  */
@@ -1068,23 +1315,23 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                         if (s[-1] == objof(&o_looper) || isforall(s[-1]))
                         {
                             ici_xs.a_top = s;
-                            goto stable_stacks_continue;
+                            NEXT_STABLE();
                         }
                     }
                 }
                 ici_error = "continue not within loop";
                 goto fail;
 
-            case OP_REWIND:
+            OP_CASE(OP_REWIND):
                 /*
                  * This is the end of a code array that is the subject
                  * of a loop. Rewind the pc back to its start.
                  */
                 o = ici_xs.a_top[-1];
                 pcof(o)->pc_next = pcof(o)->pc_code->a_base;
-                goto continue_with_same_pc;
+                NEXT_SAME_PC();
 
-            case OP_LOOPER:
+            OP_CASE(OP_LOOPER):
                 /*
                  * obj self     => obj self pc (xs)
                  *              => (os)
@@ -1098,16 +1345,16 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 *ici_xs.a_top++ = o; /* Restore formal state.*/
                 get_pc(arrayof(ici_xs.a_top[-2]), ici_xs.a_top);
                 ++ici_xs.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_ENDCODE:
+            OP_CASE(OP_ENDCODE):
                 /*
                  * pc => - (xs)
                  */
                 --ici_xs.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_LOOP:
+            OP_CASE(OP_LOOP):
                 o = *pcof(ici_xs.a_top[-1])->pc_next++;
                 *ici_xs.a_top++ = o;
                 *ici_xs.a_top++ = objof(&o_looper);
@@ -1115,7 +1362,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 ++ici_xs.a_top;
                 break;
 
-            case OP_EXEC:
+            OP_CASE(OP_EXEC):
                 /*
                  * array => - (os)
                  *       => pc (xs)
@@ -1123,9 +1370,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 get_pc(arrayof(ici_os.a_top[-1]), ici_xs.a_top);
                 ++ici_xs.a_top;
                 --ici_os.a_top;
-                continue;
+                NEXT();
 
-            case OP_SWITCHER:
+            OP_CASE(OP_SWITCHER):
                 /*
                  * NULL self (xs) =>
                  *
@@ -1133,9 +1380,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                  * without a break.
                  */
                 --ici_xs.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_SWITCH:
+            OP_CASE(OP_SWITCH):
                 /*
                  * value array struct => (os)
                  *           => NULL switcher (pc(array) + struct.value) (xs)
@@ -1143,7 +1390,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 {
                     register ici_sslot_t *sl;
 
-                    if ((sl = find_raw_slot(structof(ici_os.a_top[-1]), ici_os.a_top[-3]))->sl_key == NULL)
+                    if ((sl = find_raw_slot(structof(ici_os.a_top[-1]), ici_keyof(ici_os.a_top[-3])))->sl_key == NULL)
                     {
                         if ((sl = find_raw_slot(structof(ici_os.a_top[-1]), objof(&o_mark)))->sl_key == NULL)
                         {
@@ -1152,7 +1399,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                              * continue;
                              */
                             ici_os.a_top -= 3;
-                            goto stable_stacks_continue;
+                            NEXT_STABLE();
                         }
                     }
                     *ici_xs.a_top++ = objof(&o_null);
@@ -1162,9 +1409,9 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     ++ici_xs.a_top;
                     ici_os.a_top -= 3;
                 }
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_CRITSECT:
+            OP_CASE(OP_CRITSECT):
                 {
                     *ici_xs.a_top = (ici_obj_t *)new_catch
                     (
@@ -1181,10 +1428,10 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                     --ici_os.a_top;
                     ++ici_exec->x_critsect;
                 }
-                continue;
+                NEXT();
 
 
-            case OP_WAITFOR:
+            OP_CASE(OP_WAITFOR):
                 /*
                  * obj => - (os)
                  */
@@ -1192,26 +1439,135 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 ici_waitfor(ici_os.a_top[-1]);
                 ++ici_exec->x_critsect;
                 --ici_os.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_POP:
+            OP_CASE(OP_POP):
                 --ici_os.a_top;
-                goto stable_stacks_continue;
+                NEXT_STABLE();
 
-            case OP_BINOP:
-            case OP_BINOP_FOR_TEMP:
+            OP_CASE(OP_QUICKBINOP):
+                /*
+                 * Leads [x y binop] where x and y are names or numbers
+                 * (see optimize_binop() in compile.c).  If the names can
+                 * be got through the lookup lookaside we fetch them here
+                 * and go straight to the binop.  A comparison of two ints
+                 * is done here too, along with any o_if, o_ifbreak or
+                 * o_ifnotbreak that follows it, without pushing the
+                 * result.  Otherwise we just carry on, and x, y and the
+                 * binop are done in the usual way.
+                 */
+                {
+                    ici_obj_t   **e;
+                    ici_obj_t   *x;
+                    ici_obj_t   *y;
+                    int         t;
+
+                    e = pcof(ici_xs.a_top[-1])->pc_next;
+                    x = e[0];
+                    if (isstring(x))
+                    {
+                        if
+                        (
+                            stringof(x)->s_struct != structof(ici_vs.a_top[-1])
+                            ||
+                            stringof(x)->s_vsver != structof(ici_vs.a_top[-1])->s_vsver
+                        )
+                            NEXT_SAME_PC();
+                        x = stringof(x)->s_slot->sl_value;
+                        ++ici_lookaside_hits;
+                    }
+                    y = e[1];
+                    if (isstring(y))
+                    {
+                        if
+                        (
+                            stringof(y)->s_struct != structof(ici_vs.a_top[-1])
+                            ||
+                            stringof(y)->s_vsver != structof(ici_vs.a_top[-1])->s_vsver
+                        )
+                            NEXT_SAME_PC();
+                        y = stringof(y)->s_slot->sl_value;
+                        ++ici_lookaside_hits;
+                    }
+                    if (isint(x) && isint(y))
+                    {
+                        switch (opof(e[2])->op_code)
+                        {
+                        case t_subtype(T_EQEQ):
+                            t = intof(x)->i_value == intof(y)->i_value;
+                            break;
+
+                        case t_subtype(T_EXCLAMEQ):
+                            t = intof(x)->i_value != intof(y)->i_value;
+                            break;
+
+                        case t_subtype(T_LESS):
+                            t = intof(x)->i_value < intof(y)->i_value;
+                            break;
+
+                        case t_subtype(T_GRT):
+                            t = intof(x)->i_value > intof(y)->i_value;
+                            break;
+
+                        case t_subtype(T_LESSEQ):
+                            t = intof(x)->i_value <= intof(y)->i_value;
+                            break;
+
+                        case t_subtype(T_GRTEQ):
+                            t = intof(x)->i_value >= intof(y)->i_value;
+                            break;
+
+                        default:
+                            goto quick_binop;
+                        }
+                        o = e[3];
+                        if (o == objof(&o_ifbreak) || o == objof(&o_ifnotbreak))
+                        {
+                            pcof(ici_xs.a_top[-1])->pc_next = e + 4;
+                            if (t == (o == objof(&o_ifbreak)))
+                                goto do_break;
+                            NEXT_STABLE();
+                        }
+                        if (o == objof(&o_if))
+                        {
+                            pcof(ici_xs.a_top[-1])->pc_next = e + 5;
+                            if (!t)
+                                NEXT_STABLE();
+                            get_pc(arrayof(e[4]), ici_xs.a_top);
+                            ++ici_xs.a_top;
+                            NEXT();
+                        }
+                        pcof(ici_xs.a_top[-1])->pc_next = e + 3;
+                        *ici_os.a_top++ = t ? objof(ici_one) : objof(ici_zero);
+                        NEXT();
+                    }
+                quick_binop:
+                    pcof(ici_xs.a_top[-1])->pc_next = e + 3;
+                    ici_os.a_top[0] = ici_fetched(x);
+                    ici_os.a_top[1] = ici_fetched(y);
+                    ici_os.a_top += 2;
+                    o = e[2];
+                }
+                goto do_binop;
+
+            OP_CASE(OP_BINOP):
+            OP_CASE(OP_BINOP_FOR_TEMP):
+            do_binop:
 #ifndef BINOPFUNC
 #include        "binop.h"
 #else
                 if (ici_op_binop(o))
                     goto fail;
 #endif
-                goto continue_with_same_pc;
+                NEXT_SAME_PC();
 
             default:
+#ifdef THREADED_CODE
+            bad_op:
+#endif
                 assert(0);
             }
-            continue;
+            NEXT();
         }
 
     fail:
@@ -1220,6 +1576,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
 
             if (ici_error == NULL)
                 ici_error = "error";
+            xt = ici_xs.a_top;
             for (;;)
             {
                 if ((c = ici_unwind()) == NULL || objof(c)->o_flags & CF_EVAL_BASE)
@@ -1233,7 +1590,19 @@ ici_evaluate(ici_obj_t *code, int n_operands)
                 break;
             }
             ici_incref(c);
-            if (ici_set_val(objwsupof(ici_vs.a_top[-1]), SS(error), 's', ici_error))
+            if (ici_error_str == NULL || strcmp(ici_error, ici_error_str->s_chars) != 0)
+            {
+                ici_str_t   *s;
+
+                if ((s = ici_str_new_nul_term(ici_error)) == NULL)
+                {
+                    ici_decref(c);
+                    goto badfail;
+                }
+                ici_set_error_str(s);
+                ici_decref(s);
+            }
+            if (assign_base(ici_vs.a_top[-1], SSO(error), ici_error_str))
             {
                 ici_decref(c);
                 goto badfail;
@@ -1244,6 +1613,7 @@ ici_evaluate(ici_obj_t *code, int n_operands)
             continue;
 
         badfail:
+            ici_set_src(xt);
 #ifndef NODEBUGGING
             /*
              * This is not such a useful place to hop into the debugger on
@@ -1351,3 +1721,4 @@ ici_type_t  ici_code_type =
 #endif
 
 ici_op_t    o_quote         = {OBJ(TC_OP), NULL, OP_QUOTE};
+ici_op_t    o_quickbinop    = {OBJ(TC_OP), NULL, OP_QUICKBINOP};
@@ -89,11 +89,12 @@ struct ici_exec
  *                      NB: This is cached in ici_exec_count for the current
  *                      thread.
  *
- * x_src                The most recently executed source line tag. These tags
- *                      are placed in code arrays during compilation.  They
- *                      are no-ops with respect to execution, but allow us to
- *                      know where we are executing with respect to the
- *                      original source.
+ * x_src                A source line tag saying where we are executing with
+ *                      respect to the original source.  Code keeps these in
+ *                      a line table beside it rather than executing them, so
+ *                      this is only brought up to date by ici_set_src().
+ *                      Anything that wants the current position must call
+ *                      that first.
  *
  * x_pc_closet          An array that shadows the execution stack. pc objects
  *                      exist only in a one-to-one relationship with a fixed
@@ -93,7 +93,7 @@ exec_forall()
                     continue;
                 if (fa->fa_vaggr != objof(&o_null))
                 {
-                    if (ici_assign(fa->fa_vaggr, fa->fa_vkey, sl->sl_value))
+                    if (ici_assign(fa->fa_vaggr, fa->fa_vkey, ici_fetched(sl->sl_value)))
                         return 1;
                 }
                 if (fa->fa_kaggr != objof(&o_null))
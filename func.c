@@ -11,6 +11,7 @@
 #include "mark.h"
 #include "null.h"
 #include "primes.h"
+#include "src.h"
 #ifndef NOPROFILE
 #include "profile.h"
 #endif
@@ -46,6 +47,8 @@ mark_func(ici_obj_t *o)
         mem += ici_mark(objof(funcof(o)->f_autos));
     if (funcof(o)->f_name != NULL)
         mem += ici_mark(objof(funcof(o)->f_name));
+    if (funcof(o)->f_frame != NULL)
+        mem += ici_mark(objof(funcof(o)->f_frame));
     return mem;
 }
 
@@ -121,8 +124,6 @@ int
 ici_op_return()
 {
     ici_obj_t           **x;
-    static int          occasionally;
-    ici_obj_t           *f;
 
     if (ici_debug_active)
         ici_debug->idbg_fnresult(ici_os.a_top[-1]);
@@ -145,28 +146,11 @@ ici_op_return()
     ici_xs.a_top = x;
 
     /*
-     * If convenient, record the total nels of the autos that this function
-     * ended up with, as a hint for the auto struct allocation on next call.
-     * If it isn't convenient, do it occasionally anyway.
+     * If nothing else got hold of the autos of this call, they can be
+     * used again by the next one.
      */
-    if
-    (
-        objof(SS(_func_)->s_struct) == ici_vs.a_top[-1]
-        &&
-        SS(_func_)->s_vsver == ici_vsver
-        &&
-        isfunc(f = SS(_func_)->s_slot->sl_value)
-    )
-    {
-        funcof(f)->f_nautos = structof(ici_vs.a_top[-1])->s_nels;
-    }
-    else if (--occasionally <= 0)
-    {
-        occasionally = 10;
-        f = ici_fetch(ici_vs.a_top[-1], SSO(_func_));
-        if (isstruct(ici_vs.a_top[-1]) && isfunc(f))
-            funcof(f)->f_nautos = structof(ici_vs.a_top[-1])->s_nels;
-    }
+    if (isstruct(ici_vs.a_top[-1]) && (objof(ici_vs.a_top[-1])->o_flags & S_FRAME))
+        keep_autos(structof(ici_vs.a_top[-1]));
 
     --ici_vs.a_top;
 #ifndef NOPROFILE
@@ -176,6 +160,42 @@ ici_op_return()
     return 0;
 }
 
+/*
+ * A call in tail position (one flagged with OPC_TAIL_CALL, because its
+ * result is returned at once) of the ICI function on top of the operand
+ * stack is about to be made.  If nothing in the frame of the function
+ * making it must outlive the call (a try or a critsect), pop the frame now,
+ * just as the return after the call would, and the callee takes its place.
+ * A chain of such calls then runs in constant stack depth.  Otherwise leave
+ * it, and the call is made as usual.
+ *
+ * The pushed call operator is on top of the execution stack, as call_func()
+ * expects.  If the frame is popped the slot under its mark, which holds the
+ * caller's source marker, takes the place of that operator.
+ */
+void
+ici_tail_call_frame(void)
+{
+    ici_obj_t           **x;
+
+    if (ici_debug_active)
+        return;
+#ifndef NOPROFILE
+    if (ici_profile_active)
+        return;
+#endif
+    for (x = ici_xs.a_top - 2; !ismark(*x); --x)
+    {
+        if (x <= ici_xs.a_base || iscatch(*x))
+            return;
+    }
+    ici_xs.a_top = x;
+    if (isstruct(ici_vs.a_top[-1]) && (objof(ici_vs.a_top[-1])->o_flags & S_FRAME))
+        keep_autos(structof(ici_vs.a_top[-1]));
+    --ici_vs.a_top;
+    ici_exec->x_src = srcof(ici_xs.a_top[-1]);
+}
+
 /*
  * arg(N-1) .. arg1 arg0 nargs func     => (os) OR
  * arg(N-1) .. arg1 arg0 nargs ptr      => (os) OR
@@ -206,9 +226,13 @@ call_func(ici_obj_t *o, ici_obj_t *subject)
         ici_profile_call(f);
 #endif
 
-    if ((d = structof(copy(objof(f->f_autos)))) == NULL)
-        goto fail;
-    if (subject != NULL)
+    d = NULL;
+    if (subject == NULL)
+    {
+        if ((d = copy_autos(f, objwsupof(f->f_autos)->o_super)) == NULL)
+            goto fail;
+    }
+    else
     {
         /*
          * This is a method call, that is, it has a subject object that
@@ -222,7 +246,8 @@ call_func(ici_obj_t *o, ici_obj_t *subject)
             ici_error = buf;
             goto fail;
         }
-        objwsupof(d)->o_super = objwsupof(subject);
+        if ((d = copy_autos(f, objwsupof(subject))) == NULL)
+            goto fail;
         /*
          * Set the special instantiation variables.
          */
@@ -250,9 +275,10 @@ call_func(ici_obj_t *o, ici_obj_t *subject)
         while (fp < f->f_args->a_top && n > 0)
         {
             assert(isstring(*fp));
-            if (stringof(*fp)->s_struct == d && stringof(*fp)->s_vsver == ici_vsver)
+            if (stringof(*fp)->s_struct == d && stringof(*fp)->s_vsver == d->s_vsver)
             {
                 stringof(*fp)->s_slot->sl_value = *ap;
+                ++ici_lookaside_hits;
             }
             else
             {
@@ -280,6 +306,7 @@ call_func(ici_obj_t *o, ici_obj_t *subject)
          */
         while (--n >= 0)
             *va->a_top++ = *ap--;
+        ici_wb(d); /* Making va may have collected. */
         sl->sl_value = objof(va);
     }
     if (va != NULL)
@@ -323,4 +350,5 @@ ici_type_t  ici_func_type =
 ici_op_t    o_return        = {OBJ(TC_OP), ici_op_return};
 ici_op_t    o_call          = {OBJ(TC_OP), NULL, OP_CALL};
 ici_op_t    o_method_call   = {OBJ(TC_OP), NULL, OP_METHOD_CALL};
+ici_op_t    o_icmethod_call = {OBJ(TC_OP), NULL, OP_ICMETHOD_CALL};
 ici_op_t    o_super_call    = {OBJ(TC_OP), NULL, OP_SUPER_CALL};
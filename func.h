@@ -15,7 +15,7 @@ struct ici_func
     ici_array_t     *f_args;    /* Array of argument names. */
     ici_struct_t    *f_autos;   /* Prototype struct of autos (incl. args). */
     ici_str_t       *f_name;    /* Some name for the function (diagnostics). */
-    int             f_nautos;   /* If !=0, a hint for auto struct alloc. */
+    ici_struct_t    *f_frame;   /* Autos kept from the last call, or NULL. */
 };
 
 #define funcof(o)       ((ici_func_t *)(o))
@@ -165,6 +165,11 @@
 
 #define ICI_OBJNAMEZ    30
 
+/*
+ * The number of fast free lists, for blocks of up to 1K. See alloc.c.
+ */
+#define ICI_NFLISTS     12
+
 typedef struct ici_array    ici_array_t;
 typedef struct ici_catch    ici_catch_t;
 typedef struct ici_sslot    ici_sslot_t;
@@ -197,6 +202,7 @@ typedef struct ici_handle   ici_handle_t;
 typedef struct ici_debug    ici_debug_t;
 typedef struct ici_code     ici_code_t;
 typedef struct ici_name_id  ici_name_id_t;
+typedef struct ici_gcstats  ici_gcstats_t;
 
 /*
  * This define may be made before an include of 'ici.h' to suppress a group
@@ -268,6 +274,9 @@ extern DLI ici_array_t  ici_os;
 extern DLI ici_array_t  ici_vs;
 
 extern DLI long         ici_vsver;
+extern DLI long         ici_lookaside_hits;
+extern DLI long         ici_lookaside_misses;
+extern DLI long         ici_lookaside_flushes;
 
 #define NSUBEXP         (10)
 extern DLI int  re_bra[(NSUBEXP + 1) * 3];
@@ -276,8 +285,19 @@ extern DLI int  re_nbra;
 extern DLI volatile int ici_aborted;            /* See exec.c */
 
 extern DLI int  ici_dont_record_line_nums;      /* See lex.c */
+extern DLI int  ici_dont_optimize;              /* See compile.c */
 extern DLI char *ici_buf;                       /* See buf.h */
 extern DLI int  ici_bufz;                       /* See buf.h */
+extern DLI int  ici_gc_nongenerational;          /* See object.c */
+extern DLI long ici_gc_pause;                   /* See object.c */
+extern DLI int  ici_gc_threads;                 /* See object.c */
+extern DLI double ici_gc_growth;                /* See object.c */
+extern DLI long ici_gc_min_heap;                /* See object.c */
+extern DLI long ici_gc_max_heap;                /* See object.c */
+extern DLI double ici_gc_cpu;                   /* See object.c */
+extern DLI long ici_gc_ceiling;                 /* See object.c */
+extern DLI int  ici_gc_defer;                   /* See object.c */
+extern DLI int  ici_gc_marking;                 /* See object.c */
 
 extern DLI ici_ftype_t  ici_stdio_ftype;
 extern DLI ici_ftype_t  ici_popen_ftype;
@@ -314,6 +334,9 @@ extern int              ici_parse_file(char *, char *, ici_ftype_t *);
 extern ici_array_t      *ici_array_new(ptrdiff_t);
 extern ici_mem_t        *ici_mem_new(void *, size_t, int, void (*)());
 extern ici_str_t        *ici_str_alloc(int);
+extern ici_str_t        *ici_str_lazy(ici_str_t *);
+extern ici_str_t        *ici_str_append(ici_str_t *, ici_str_t *, int);
+extern ici_str_t        *ici_str_sub(ici_str_t *, int, int);
 extern ici_str_t        *ici_str_new_nul_term(char *);
 extern ici_str_t        *ici_str_get_nul_term(char *);
 extern ici_set_t        *ici_set_new(void);
@@ -347,6 +370,10 @@ extern ici_file_t       *ici_need_stdin(void);
 extern ici_file_t       *ici_need_stdout(void);
 extern ici_array_t      *ici_need_path(void);
 extern void             ici_reclaim(void);
+extern void             ici_gc_freeze(void);
+extern void             ici_gc_thaw(void);
+extern void             ici_gc_stats(ici_gcstats_t *);
+extern int              ici_heap_dump(ici_file_t *);
 extern int              ici_str_ret(char *);
 extern int              ici_float_ret(double);
 extern int              ici_func(ici_obj_t *, char *, ...);
@@ -358,6 +385,7 @@ extern int              ici_cmkvar(ici_objwsup_t *, char *, int, void *);
 extern int              ici_set_val(ici_objwsup_t *, ici_str_t *, int, void *);
 extern int              ici_fetch_num(ici_obj_t *, ici_obj_t *, double *);
 extern int              ici_fetch_int(ici_obj_t *, ici_obj_t *, long *);
+extern int              ici_fetch_mismatch(ici_obj_t *, ici_obj_t *, ici_obj_t *, char *);
 extern int              ici_assign_cfuncs(ici_objwsup_t *, ici_cfunc_t *);
 extern int              ici_def_cfuncs(ici_cfunc_t *);
 extern int              ici_main(int, char **);
@@ -366,6 +394,9 @@ extern ici_handle_t     *ici_handle_new(void *, ici_str_t *, ici_objwsup_t *);
 extern ici_handle_t     *ici_handle_probe(void *, ici_str_t *);
 extern int              ici_register_type(ici_type_t *t);
 extern void             ici_rego_work(ici_obj_t *o);
+extern void             ici_remember(ici_obj_t *o);
+extern void             ici_gc_shade(ici_obj_t *o);
+extern unsigned long    ici_mark_defer(ici_obj_t *o);
 extern ptrdiff_t        ici_array_nels(ici_array_t *);
 extern int              ici_grow_stack(ici_array_t *, ptrdiff_t);
 extern int              ici_fault_stack(ici_array_t *, ptrdiff_t);
@@ -376,6 +407,7 @@ extern ici_obj_t        *ici_array_pop(ici_array_t *);
 extern ici_obj_t        *ici_array_rpop(ici_array_t *);
 extern ici_obj_t        *ici_array_get(ici_array_t *, ptrdiff_t);
 extern void             ici_invalidate_struct_lookaside(ici_struct_t *);
+extern void             ici_invalidate_lookasides(void);
 extern int              ici_engine_stack_check(void);
 extern void             ici_atexit(void (*)(void), ici_wrap_t *);
 extern ici_objwsup_t    *ici_class_new(ici_cfunc_t *cf, ici_objwsup_t *super);
@@ -460,16 +492,40 @@ extern void     trace_pcall(ici_obj_t *);
 
 typedef struct expr         expr_t;
 typedef struct ici_ostemp   ici_ostemp_t;
+typedef struct ici_icache   ici_icache_t;
+
+/*
+ * The size of a set of chars made by ici_byteset(), and whether the char c
+ * is in it.
+ */
+#define ICI_BYTESETZ    (256 / 8)
+#define ici_byte_in(set, c) \
+    ((set)[(unsigned char)(c) >> 3] & (1 << ((unsigned char)(c) & 7)))
 
 extern ici_obj_t        *ici_evaluate(ici_obj_t *, int);
 extern char             **smash(char *, int);
 extern char             **ssmash(char *, char *);
+extern void             ici_byteset(unsigned char *, char *, int);
+extern char             *ici_byte_find(char *, char *, unsigned char *);
+extern char             *ici_byte_span(char *, char *, unsigned char *);
+extern ici_obj_t        *ici_charbuf_getline(ici_file_t *);
+extern ici_ftype_t      ici_charbuf_ftype;
+extern ici_ftype_t      ici_strbuf_ftype;
 extern int              ici_natoms;
 extern void             ici_grow_atoms(ptrdiff_t newz);
 extern int              ici_supress_collect;
+extern int              ici_gc_sweeping;
 extern char             *ici_binop_name(int);
 extern ici_sslot_t      *find_slot(ici_struct_t **, ici_obj_t *);
 extern ici_sslot_t      *find_raw_slot(ici_struct_t *, ici_obj_t *);
+extern void             ici_struct_wb_super(ici_struct_t *, ici_sslot_t *);
+extern ici_icache_t     *ici_icache_new(ici_str_t *);
+extern ici_obj_t        *ici_fetch_icached(ici_icache_t *, ici_obj_t *);
+extern void             ici_invalidate_icaches(ici_struct_t *);
+extern long             ici_icache_epoch;
+extern ici_struct_t     *copy_autos(ici_func_t *, ici_objwsup_t *);
+extern void             keep_autos(ici_struct_t *);
+extern void             ici_tail_call_frame(void);
 extern ici_obj_t        *atom_probe(ici_obj_t *, ici_obj_t ***);
 extern int              parse_exec(void);
 extern ici_parse_t      *new_parse(ici_file_t *);
@@ -478,6 +534,10 @@ extern ici_func_t       *new_func(void);
 extern ici_op_t         *new_op(int (*)(), int, int);
 extern ici_pc_t         *new_pc(void);
 extern ici_src_t        *new_src(int, ici_str_t *);
+extern int              ici_src_table(ici_array_t *, ptrdiff_t);
+extern void             ici_set_error_str(ici_str_t *);
+extern ici_src_t        *ici_src_find(ici_array_t *, ptrdiff_t, int *);
+extern void             ici_set_src(ici_obj_t **);
 extern ici_catch_t      *ici_unwind(void);
 extern void             collect(void);
 extern unsigned long    ici_hash_string(ici_obj_t *);
@@ -522,6 +582,7 @@ extern ici_obj_t        **objs;
 extern ici_obj_t        **objs_top;
 extern ici_obj_t        **objs_limit;
 extern ici_obj_t        **atoms;
+extern unsigned long    *atom_hashes;
 extern int              atomsz;
 
 extern DLI ici_ftype_t  ici_parse_ftype;
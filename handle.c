@@ -328,14 +328,14 @@ assign_base_handle(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
          * We don't yet have a private struct to hold our values.
          * Give ourselves one.
          *
-         * This operation disturbs the struct-lookup lookaside mechanism.
-         * We invalidate all existing entries by incrementing ici_vsver.
+         * Being empty, it doesn't change what is found through us, so
+         * struct-lookup lookasides are unaffected.  Anything we assign
+         * into it takes over the lookaside of its key.
          */
         if ((s = objwsupof(ici_struct_new())) == NULL)
             return 1;
         s->o_super = objwsupof(o)->o_super;
         objwsupof(o)->o_super = s;
-        ++ici_vsver;
         o->o_flags |= H_HAS_PRIV_STRUCT;
     }
     return assign_base(objwsupof(o)->o_super, k, v);
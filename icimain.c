@@ -162,6 +162,15 @@ ici_main(int argc, char *argv[])
                             arg0 = argv[i];
                         break;
 
+                    case 'O':
+                        /*
+                         * Done here, before anything is parsed.
+                         */
+                        if (argv[i][j + 1] == '0' || argv[i][j + 1] == '1')
+                            ++j;
+                        ici_dont_optimize = argv[i][j] == '0';
+                        continue;
+
                     case '0': case '1': case '2': case '3': case '4':
                     case '5': case '6': case '7': case '8': case '9':
                         continue;
@@ -313,6 +322,11 @@ ici_main(int argc, char *argv[])
                     }
                     break;
 
+                case 'O':
+                    if (argv[i][j + 1] == '0' || argv[i][j + 1] == '1')
+                        ++j;
+                    continue;
+
                 case '0': case '1': case '2': case '3': case '4':
                 case '5': case '6': case '7': case '8': case '9':
                     if ((stream = fdopen(argv[i][j] - '0', "r")) == NULL)
@@ -350,7 +364,7 @@ ici_main(int argc, char *argv[])
 
 usage:
     fprintf(stderr, "usage1: %s file args...\n", argv[0]);
-    fprintf(stderr, "usage2: %s [-f file] [-] [-e prog] [-#] [-l mod] [-m name] [--] args...\n", argv[0]);
+    fprintf(stderr, "usage2: %s [-f file] [-] [-e prog] [-#] [-l mod] [-m name] [-O0] [--] args...\n", argv[0]);
     fprintf(stderr, "usage3: %s [-h | -? | -v]\n", argv[0]);
     if (!help)
     {
@@ -371,6 +385,7 @@ usage:
         fprintf(stderr, " -#       Parses from the file descriptor #.\n");
         fprintf(stderr, " -l mod   Loads the module 'mod' as if by load().\n");
         fprintf(stderr, " -m name  Sets the ICI argv[0] to name.\n");
+        fprintf(stderr, " -O0      Compiles code without constant folding and fused operations.\n");
         fprintf(stderr, " --       Place following arguments in the ICI argv without interpretation.\n");
         fprintf(stderr, " args...  Otherwise unused arguments are placed in the ICI argv.\n");
         fprintf(stderr, "\n");
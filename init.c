@@ -59,13 +59,13 @@ ici_init(void)
         return 1;
     if (ici_init_object())
         return 1;
-    for (i = 0; i < nels(ici_small_ints); ++i)
+    for (i = ICI_SMALL_INT_MIN; i < ICI_SMALL_INT_MAX; ++i)
     {
-        if ((ici_small_ints[i] = ici_int_new(i)) == NULL)
+        if ((ici_small_int(i) = ici_int_new(i)) == NULL)
             return 1;
     }
-    ici_zero = ici_small_ints[0];
-    ici_one = ici_small_ints[1];
+    ici_zero = ici_small_int(0);
+    ici_one = ici_small_int(1);
     /*
      * I'm hoping that from this point forward, there should be no risk of
      * memory leaks in the initialisation: everything is either static or
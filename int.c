@@ -2,7 +2,7 @@
 #include "int.h"
 #include "primes.h"
 
-ici_int_t                   *ici_small_ints[32];
+ici_int_t                   *ici_small_ints[ICI_SMALL_INT_COUNT];
 
 /*
  * Mark this and referenced unmarked objects, return memory costs.
@@ -69,7 +69,7 @@ ici_int_new(long i)
     ici_obj_t           *o;
     ici_obj_t           **po;
 
-    if ((i & ~ICI_SMALL_INT_MASK) == 0 && (o = objof(ici_small_ints[i])) != NULL)
+    if (ici_is_small_int(i) && (o = objof(ici_small_int(i))) != NULL)
     {
         ici_incref(o);
         return intof(o);
@@ -81,7 +81,7 @@ ici_int_new(long i)
         --po < atoms ? po = atoms + atomsz - 1 : NULL
     )
     {
-        if (isint(o) && intof(o)->i_value == i)
+        if (isint(o) && intof(o)->i_value == i && !ici_atom_dead(o))
         {
             ici_incref(o);
             return intof(o);
@@ -97,6 +97,7 @@ ici_int_new(long i)
     ici_rego(o);
     intof(o)->i_value = i;
     --ici_supress_collect;
+    atom_hashes[po - atoms] = (unsigned long)i * INT_PRIME;
     ICI_STORE_ATOM_AND_COUNT(po, o);
     return intof(o);
 }
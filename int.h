@@ -24,7 +24,19 @@ struct ici_int
  * End of ici.h export. --ici.h-end--
  */
 
-#define ICI_SMALL_INT_MASK  0x1F
-extern ici_int_t            *ici_small_ints[32];
+/*
+ * Ints from ICI_SMALL_INT_MIN up to (but not including) ICI_SMALL_INT_MAX
+ * are made at startup and never freed.  Making one of these (as loop
+ * counters, indexes, character codes and the like do all the time) is then
+ * just a table look-up, with no trip to the atom pool and nothing for the
+ * garbage collector to do later.
+ */
+#define ICI_SMALL_INT_MIN   (-128)
+#define ICI_SMALL_INT_MAX   1024
+#define ICI_SMALL_INT_COUNT (ICI_SMALL_INT_MAX - ICI_SMALL_INT_MIN)
+#define ici_is_small_int(i) \
+    ((unsigned long)((i) - ICI_SMALL_INT_MIN) < (unsigned long)ICI_SMALL_INT_COUNT)
+#define ici_small_int(i)    ici_small_ints[(i) - ICI_SMALL_INT_MIN]
+extern ici_int_t            *ici_small_ints[ICI_SMALL_INT_COUNT];
 
 #endif /* ICI_INT_H */
@@ -80,6 +80,7 @@ get(ici_parse_t *p, ici_array_t *a)
             if ((*a->a_top = objof(new_src(p->p_lineno, p->p_file->f_name))) != NULL)
             {
                 ici_decref(*a->a_top);
+                ici_wb(a);
                 ++a->a_top;
             }
         }
@@ -444,6 +444,7 @@ push_path_elements(ici_array_t *a, char *path)
             ici_decref(s);
             return 1;
         }
+        ici_wb(a); /* The path array is only held by externs. */
         *a->a_top++ = objof(s);
     skip:
         ici_decref(s);
@@ -8,8 +8,22 @@
 #include "pc.h"
 #include "profile.h"
 #include "primes.h"
+#include "struct.h"
+#include "src.h"
+#include "file.h"
 
 #include <limits.h>
+#include <time.h>
+/*
+ * Marking can be shared with helper threads where we have POSIX threads
+ * and the GCC atomic builtins.  See gc_par_run().
+ */
+#if defined(ICI_USE_POSIX_THREADS) && defined(__GNUC__)
+#define GC_PARALLEL
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#endif
 
 /*
  * The following define is useful during debug and testing. It will
@@ -20,6 +34,12 @@
  */
 #define ALLCOLLECT      0       /* Collect on every alloc call. */
 
+/*
+ * The least amount of allocation (in the terms of ici_mem_used) between
+ * minor garbage collections. See collect().
+ */
+#define GC_NURSERY      (64 * 1024)
+
 /*
  * The global error message pointer. The ICI error return convention
  * dictacts that the originator of an error sets this to point to a
@@ -61,6 +81,7 @@ extern ici_type_t       ici_handle_type;
 extern ici_type_t       profilecall_type;
 extern ici_type_t       mem_type;
 extern ici_type_t       ici_code_type;
+extern ici_type_t       icache_type;
 
 ici_type_t      *ici_types[ICI_MAX_TYPES] =
 {
@@ -96,8 +117,9 @@ ici_type_t      *ici_types[ICI_MAX_TYPES] =
 #   if 0
         &ici_code_type,
 #   else
-        NULL
+        NULL,
 #   endif
+    &icache_type,
 };
 
 static int              ici_ntypes = TC_MAX_CORE + 1;
@@ -111,11 +133,182 @@ ici_obj_t       **objs_limit;   /* First element we can't use in list. */
 ici_obj_t       **objs_top;     /* Next unused element in list. */
 
 ici_obj_t       **atoms;        /* Hash table of atomic objects. */
+unsigned long   *atom_hashes;   /* The hash of each, just after atoms[]. */
 int             atomsz;         /* Number of slots in hash table. */
 int             ici_natoms;     /* Number of atomic objects. */
 
 int             ici_supress_collect;
 
+/*
+ * State of the generational garbage collector. See collect() below.
+ */
+typedef struct gclist   gclist_t;
+struct gclist
+{
+    ici_obj_t           **l_base;
+    ici_obj_t           **l_top;
+    ici_obj_t           **l_limit;
+};
+
+static ptrdiff_t        objs_nold;      /* objs[0..objs_nold) are old. */
+static gclist_t         gc_held;        /* Old objects with nrefs at last GC. */
+static gclist_t         gc_rescans;     /* Old objects of unbarriered types. */
+static int              gc_need_major;  /* Next collection must be major. */
+static long             gc_old_limit;   /* ici_mem_used to trigger a major. */
+
+/*
+ * The frozen generation.  See ici_gc_freeze().  There is no o_flags bit to
+ * spare for saying an object is frozen, so they are kept in gc_frozen_set,
+ * an open addressed hash table of their addresses.  An entry has its low
+ * bit (GC_THAWED) set once its object has been thawed.
+ */
+static ptrdiff_t        objs_nfrozen;   /* objs[0..objs_nfrozen) are frozen. */
+static ici_obj_t        **gc_frozen_set; /* Hash table of them, or NULL. */
+static size_t           gc_frozen_setz; /* Its size, a power of 2. */
+static gclist_t         gc_thawed;      /* Those that have been thawed. */
+static int              gc_thawing;     /* gc_thawed is out of date. */
+
+#define GC_THAWED       1UL
+#define gc_frozen_obj(e) ((ici_obj_t *)((unsigned long)(e) & ~GC_THAWED))
+#define gc_is_thawed(e) (((unsigned long)(e) & GC_THAWED) != 0)
+
+/*
+ * The remembered set. Old objects that have been modified since the last
+ * collection, as recorded by ici_wb(). It is of fixed size so the write
+ * barrier never has to allocate. Overflow just forces the next collection
+ * to be a major one.
+ */
+static ici_obj_t        *gc_remembered[4096];
+static int              gc_nremembered;
+
+/*
+ * Set (non-zero) to make every collection a full (major) one, as was always
+ * done by older versions of ICI.
+ *
+ * This --variable-- forms part of the --ici-api--.
+ */
+int             ici_gc_nongenerational;
+
+/*
+ * Incremental major collections.  Rather than stopping everything while the
+ * whole heap is marked and swept, a major collection proceeds as a series
+ * of steps, one each time ici_mem_limit is reached, between which the
+ * program runs on.  See collect() below.
+ */
+#define GC_IDLE         0       /* No major collection in progress. */
+#define GC_CLEAR        1       /* Clearing the marks of all objects. */
+#define GC_MARK         2       /* Marking from the roots. */
+#define GC_SWEEP        3       /* Freeing what wasn't marked. */
+
+/*
+ * The amount of allocation (in the terms of ici_mem_used) between the steps
+ * of an incremental major collection, and the number of objects each phase
+ * deals with between looks at the clock.
+ */
+#define GC_STEP         (16 * 1024)
+#define GC_QUANTUM      256
+
+static int              gc_phase;       /* One of GC_* above. */
+static int              gc_reclaiming;  /* In ici_reclaim(). */
+static ptrdiff_t        gc_pos;         /* Progress through objs[]. */
+static ptrdiff_t        gc_sweep_to;    /* Survivors are compacted to here. */
+static ptrdiff_t        gc_sweep_end;   /* objs[gc_sweep_end..] are newer. */
+static gclist_t         gc_grey;        /* Marked, but not yet looked in. */
+
+/*
+ * The time, in microseconds, that each step of an incremental major
+ * collection tries to keep within.  Zero (the default) makes every major
+ * collection run to completion at once.  Steps shorten the longest pause,
+ * but cost throughput: while marking goes on, an object changed by the
+ * program must be looked in again in full, and a big array that is added
+ * to is then looked through at every step.
+ *
+ * This --variable-- forms part of the --ici-api--.
+ */
+long            ici_gc_pause;
+
+/*
+ * The number of helper threads that take part, along with the thread doing
+ * the collection, in the marking of a major collection.  Zero (the default)
+ * has all marking done by the collecting thread alone.  See gc_par_run()
+ * below.
+ *
+ * This --variable-- forms part of the --ici-api--.
+ */
+int             ici_gc_threads;
+
+/*
+ * The policy by which major collections are triggered.  After each one,
+ * the next is due when ici_mem_used reaches ici_gc_growth times what was
+ * left, but not less than ici_gc_min_heap bytes, and, if ici_gc_max_heap
+ * is non-zero, not more than it (unless what was left is already so near
+ * it that collections would follow one another, in which case a quarter of
+ * the usual growth is still allowed).
+ *
+ * If ici_gc_cpu is non-zero it is the fraction of the CPU time used by the
+ * program that collection should stay within.  When more than that went
+ * on collection between one major collection and the next, the growth
+ * allowed is increased, and when it is well under it is brought back down
+ * to ici_gc_growth again.
+ *
+ * If ici_gc_ceiling is non-zero, it is a hard limit on ici_mem_used.  An
+ * allocation that would take the heap past it first causes a full
+ * collection, then fails if that didn't free enough.  So that there is
+ * room to handle the failure, the heap may then go an eighth past it
+ * until a collection finds it back under (see mem_over() in alloc.c).
+ *
+ * These --variables-- form part of the --ici-api--.
+ */
+double          ici_gc_growth = 2.0;
+long            ici_gc_min_heap = 32 * 1024;
+long            ici_gc_max_heap;
+double          ici_gc_cpu;
+long            ici_gc_ceiling;
+
+static double           gc_growth = 2.0;/* Growth now in effect. */
+static clock_t          gc_cpu_used;    /* In collect() since gc_cpu_mark. */
+static clock_t          gc_cpu_mark;    /* clock() at end of last major. */
+
+/*
+ * Statistics, see ici_gc_stats().
+ */
+static long             gc_minors;      /* Minor collections done. */
+static long             gc_majors;      /* Major collections finished. */
+static double           gc_pause_total; /* Time in collect() (gc_clock()). */
+static double           gc_pause_max;   /* Longest call of collect(). */
+static long             gc_frozen_objs[ICI_MAX_TYPES];  /* By type, when */
+static long             gc_frozen_bytes[ICI_MAX_TYPES]; /* ...frozen. */
+
+/*
+ * Set while ici_heap_dump() is finding what an object references.  The
+ * mark functions hand each unmarked object they reach to ici_mark_defer(),
+ * which just adds it to gc_dump_refs.
+ */
+static int              gc_dumping;
+static int              gc_dump_failed; /* gc_dump_refs couldn't grow. */
+static gclist_t         gc_dump_refs;
+
+/*
+ * Set while the collector is in a step of the marking phase of an
+ * incremental collection.  This makes ici_mark() defer the marking of what
+ * an object references rather than recursing.
+ *
+ * This --variable-- forms part of the --ici-api--.
+ */
+int             ici_gc_defer;
+
+/*
+ * Set while an incremental collection is marking.  See ici_incref().
+ *
+ * This --variable-- forms part of the --ici-api--.
+ */
+int             ici_gc_marking;
+
+/*
+ * Set while an incremental collection is sweeping.  See ici_atom_dead().
+ */
+int             ici_gc_sweeping;
+
 /*
  * Format a human readable version of the object 'o' into the buffer
  * 'p' in less than 30 chars. Returns 'p'. See 'The error return
@@ -286,28 +479,37 @@ ici_hash_unique(ici_obj_t *o)
 }
 
 /*
- * Grow the hash table of atoms to the given size, which *must* be a
- * power of 2.
+ * Build the hash table of atoms afresh at the given size, which *must* be a
+ * power of 2 and big enough.  The hash of each atom is kept in
+ * atom_hashes[], at the same index as the atom, so they are moved without
+ * being worked out again.  If 'dropdead', the atoms a collection has found
+ * to be garbage (which must all be in the part of objs[] it is about to
+ * sweep) are left out, and are no longer atoms.  Returns non-zero, with
+ * the pool as it was, if the memory couldn't be had.
  */
-static void
-ici_grow_atoms_core(ptrdiff_t newz)
+static int
+ici_grow_atoms_core(ptrdiff_t newz, int dropdead)
 {
     register ici_obj_t  **po;
     register int        i;
     ici_obj_t           **olda;
+    unsigned long       *oldh;
+    unsigned long       h;
     ptrdiff_t           oldz;
 
     assert(((newz - 1) & newz) == 0); /* Assert power of 2. */
     oldz = atomsz;
     ++ici_supress_collect;
-    po = (ici_obj_t **)ici_nalloc(newz * sizeof(ici_obj_t *));
+    po = (ici_obj_t **)ici_nalloc(ICI_ATOMS_SIZE(newz));
     --ici_supress_collect;
     if (po == NULL)
-        return;
+        return 1;
     atomsz = newz;
     memset((char *)po, 0, newz * sizeof(ici_obj_t *));
     olda = atoms;
+    oldh = atom_hashes;
     atoms = po;
+    atom_hashes = (unsigned long *)(atoms + newz);
     i = oldz;
     while (--i >= 0)
     {
@@ -315,17 +517,41 @@ ici_grow_atoms_core(ptrdiff_t newz)
 
         if ((o = olda[i]) != NULL)
         {
+            if (dropdead && o->o_nrefs == 0 && (o->o_flags & O_MARK) == 0)
+            {
+                o->o_flags &= ~O_ATOM;
+                --ici_natoms;
+                continue;
+            }
+            h = oldh[i];
             for
             (
-                po = &atoms[ici_atom_hash_index(hash(o))];
+                po = &atoms[ici_atom_hash_index(h)];
                 *po != NULL;
                 --po < atoms ? po = atoms + atomsz - 1 : NULL
             )
                 ;
             *po = o;
+            atom_hashes[po - atoms] = h;
         }
     }
-    ici_nfree(olda, oldz * sizeof(ici_obj_t *));
+    ici_nfree(olda, ICI_ATOMS_SIZE(oldz));
+    return 0;
+}
+
+/*
+ * The size of atom pool to have for 'n' atoms, a quarter full.  Growth
+ * (see ici_atom()) doubles it when more than half full, and after a
+ * collection it is made smaller if less than an eighth full.
+ */
+static ptrdiff_t
+atoms_size_for(long n)
+{
+    ptrdiff_t           z;
+
+    for (z = 64; z < 4 * n; z *= 2)
+        ;
+    return z;
 }
 
 /*
@@ -347,7 +573,59 @@ ici_grow_atoms(ptrdiff_t newz)
         if (ici_natoms * 8 < newz)
             return;
     }
-    ici_grow_atoms_core(newz);
+    ici_grow_atoms_core(newz, 0);
+}
+
+/*
+ * Replace the lazy atoms (see ici_is_lazy_atom()) from e up to limit, which
+ * are elements of 'o', with their atomic forms.
+ */
+static void
+atom_lazy_span(ici_obj_t *o, ici_obj_t **e, ici_obj_t **limit)
+{
+    for (; e < limit; ++e)
+    {
+        if (ici_is_lazy_atom(*e))
+        {
+            ici_wb(o);
+            *e = ici_atom(ici_fetched(*e), 0);
+        }
+    }
+}
+
+/*
+ * Arrays and structs compare and hash what they hold by identity, but a
+ * lazy atom is equal to the atom it would become.  So before one is looked
+ * for in the atom pool, the lazy atoms among its elements (or a struct's
+ * values) are replaced by their atomic forms.  The program can't tell the
+ * difference, and equal aggregates then find each other.  Struct and set
+ * keys have already been made atoms (see ici_keyof()).
+ */
+static void
+atom_lazy_parts(ici_obj_t *o)
+{
+    ici_array_t         *a;
+    ici_sslot_t         *sl;
+
+    if (isarray(o))
+    {
+        a = arrayof(o);
+        if (a->a_bot <= a->a_top)
+            atom_lazy_span(o, a->a_bot, a->a_top);
+        else
+        {
+            atom_lazy_span(o, a->a_bot, a->a_limit);
+            atom_lazy_span(o, a->a_base, a->a_top);
+        }
+    }
+    else if (isstruct(o))
+    {
+        for (sl = structof(o)->s_slots; sl < structof(o)->s_slots + structof(o)->s_nslots; ++sl)
+        {
+            if (sl->sl_key != NULL)
+                atom_lazy_span(o, &sl->sl_value, &sl->sl_value + 1);
+        }
+    }
 }
 
 /*
@@ -370,6 +648,8 @@ ici_grow_atoms(ptrdiff_t newz)
  * atom pool), a copy will made and that copy stored in the atom pool and
  * returned.  Also note that if lone is 1 and the object is not used, the
  * nrefs of the passed object will be transfered to the object being returned.
+ * An object that is already immutable (see ici_is_lazy_atom()) is never
+ * copied.  It just becomes the atom itself.
  *
  * Never fails, at worst it just returns its argument (for historical
  * reasons).
@@ -379,23 +659,38 @@ ici_grow_atoms(ptrdiff_t newz)
 ici_obj_t *
 ici_atom(ici_obj_t *o, int lone)
 {
-    ici_obj_t   **po;
+    ici_obj_t           **po;
+    unsigned long       h;
+    int                 copied;
 
     assert(!(lone == 1 && o->o_nrefs == 0));
 
     if (o->o_flags & O_ATOM)
         return o;
+    atom_lazy_parts(o);
+    h = hash(o);
     for
     (
-        po = &atoms[ici_atom_hash_index(hash(o))];
+        po = &atoms[ici_atom_hash_index(h)];
         *po != NULL;
         --po < atoms ? po = atoms + atomsz - 1 : NULL
     )
     {
-        if (o->o_tcode == (*po)->o_tcode && cmp(o, *po) == 0)
+        if
+        (
+            atom_hashes[po - atoms] == h
+            &&
+            o->o_tcode == (*po)->o_tcode
+            &&
+            !ici_atom_dead(*po)
+            &&
+            cmp(o, *po) == 0
+        )
         {
             if (lone)
             {
+                if (ici_gc_marking)
+                    ici_gc_shade(*po);
                 (*po)->o_nrefs += o->o_nrefs;
                 o->o_nrefs = 0;
             }
@@ -406,7 +701,8 @@ ici_atom(ici_obj_t *o, int lone)
     /*
      * Not found.  Add this object (or a copy of it) to the atom pool.
      */
-    if (!lone)
+    copied = !lone && !ici_is_lazy_atom(o);
+    if (copied)
     {
         ++ici_supress_collect;
         *po = copy(o);
@@ -416,10 +712,15 @@ ici_atom(ici_obj_t *o, int lone)
         o = *po;
     }
     *po = o;
+    atom_hashes[po - atoms] = h;
     o->o_flags |= O_ATOM;
+    if (isstring(o))
+        stringof(o)->s_hash = (unsigned int)h; /* See ici_hash_string(). */
+    if (ici_gc_sweeping)
+        o->o_flags |= O_MARK;
     if (++ici_natoms > atomsz / 2)
         ici_grow_atoms(atomsz * 2);
-    if (!lone)
+    if (copied)
         ici_decref(o);
     return o;
 }
@@ -432,25 +733,40 @@ ici_atom(ici_obj_t *o, int lone)
  * The caller may use this to store the new object in *provided* the atom pool
  * is not disturbed in the meantime, and is checked for possible growth
  * afterwards.  The macro ICI_STORE_ATOM_AND_COUNT() can be used for this.
+ * The object's hash has already been stored in atom_hashes[] for that slot.
  * Note that any call to collect() could disturb the atom pool.
  */
 ici_obj_t *
 atom_probe(ici_obj_t *o, ici_obj_t ***ppo)
 {
-    ici_obj_t   **po;
+    ici_obj_t           **po;
+    unsigned long       h;
 
+    h = hash(o);
     for
     (
-        po = &atoms[ici_atom_hash_index(hash(o))];
+        po = &atoms[ici_atom_hash_index(h)];
         *po != NULL;
         --po < atoms ? po = atoms + atomsz - 1 : NULL
     )
     {
-        if (o->o_tcode == (*po)->o_tcode && cmp(o, *po) == 0)
+        if
+        (
+            atom_hashes[po - atoms] == h
+            &&
+            o->o_tcode == (*po)->o_tcode
+            &&
+            !ici_atom_dead(*po)
+            &&
+            cmp(o, *po) == 0
+        )
             return *po;
     }
     if (ppo != NULL)
+    {
+        atom_hashes[po - atoms] = h;
         *ppo = po;
+    }
     return NULL;
 }
 
@@ -519,7 +835,7 @@ delete:
             sl = atoms + atomsz - 1;
         if (*sl == NULL)
             break;
-        ws = &atoms[ici_atom_hash_index(hash(*sl))];
+        ws = &atoms[ici_atom_hash_index(atom_hashes[sl - atoms])];
         if
         (
             (sl < ss && (ws >= ss || ws < sl))
@@ -533,6 +849,7 @@ delete:
              * ss to be here (which now becomes empty).
              */
             *ss = *sl;
+            atom_hashes[ss - atoms] = atom_hashes[sl - atoms];
             ss = sl;
         }
     }
@@ -577,205 +894,1972 @@ ici_rego_work(ici_obj_t *o)
 }
 
 /*
- * Mark sweep garbage collection.  Should be safe to do any time, as new
- * objects are created without the nrefs == 0 which allows them to be
- * collected.  They must be explicitly lost before they are subject
- * to garbage collection.  But of course all code must be careful not
- * to hang on to "found" objects where they are not accessible, or they
- * will be collected.  You can ici_incref() them if you want.  All "held" objects
- * will cause all objects referenced from them to be marked (ie, not
- * collected), as long as they are registered on either the global object
- * list or in the atom pool.  Thus statically declared objects which
- * reference other objects (very rare) must be appropriately registered.
+ * Objects of these core types only ever come to reference younger objects
+ * through stores that apply the write barrier (arrays, structs and sets),
+ * or never change what they reference once they are made.  Old objects of
+ * all other types, including all types registered by extensions, are
+ * re-scanned by every minor collection.
  */
-void
-collect(void)
-{
-    register ici_obj_t  **a;
-    register ici_obj_t  *o;
-    register ici_obj_t  **b;
-    /*register int        ndead_atoms;*/
-    register long       mem;    /* Total mem tied up in refed objects. */
+#define GC_BARRIERED_TYPES \
+    ( 1L << TC_SRC    | 1L << TC_OP     | 1L << TC_STRING | 1L << TC_INT    \
+    | 1L << TC_FLOAT  | 1L << TC_REGEXP | 1L << TC_PTR    | 1L << TC_ARRAY  \
+    | 1L << TC_STRUCT | 1L << TC_SET    | 1L << TC_CFUNC  | 1L << TC_METHOD \
+    | 1L << TC_MARK   | 1L << TC_NULL   | 1L << TC_MEM    | 1L << TC_ICACHE)
 
-    if (ici_supress_collect)
-    {
-        /*
-         * There are some times when it is a bad idea to collect. Basically
-         * when we are allocating, or fiddling with, basic data structures like
-         * the atom pool and object list; and during recursive calls.
-         */
-        return;
-    }
-    ++ici_supress_collect;
+#define gc_rescan(o)    ((o)->o_tcode > TC_MAX_CORE \
+                        || (GC_BARRIERED_TYPES & (1L << (o)->o_tcode)) == 0)
 
-#   ifndef NDEBUG
-    /*
-     * In debug builds we take this opportunity to check the consistency of of
-     * the atom pool.  We check that each entry has the O_ATOM flag set, and
-     * that it can be found in the pool (i.e.  that its hash is the same as
-     * when it was inserted).  A failure here is a common result of a hash
-     * and/or cmp function that considers information that changes during the
-     * life of the object.
-     */
-    {
-        ici_obj_t   **a;
+/*
+ * The types that C code builds up with direct stores, without the write
+ * barrier, while it holds a reference to the new object.
+ */
+#define gc_container(o) ((o)->o_tcode == TC_ARRAY \
+                        || (o)->o_tcode == TC_STRUCT \
+                        || (o)->o_tcode == TC_SET)
 
-        if ((a = &atoms[atomsz]) != NULL)
-        {
-            while (--a >= atoms)
-            {
-                if (*a == NULL)
-                    continue;
-                assert((*a)->o_flags & O_ATOM);
-                assert(atom_probe(*a, NULL) == *a);
-            }
-        }
-    }
-#   endif
-    /*
-     * Mark all objects which are referenced (and thus what they ref).
-     */
-    mem = 0;
-    for (a = objs; a < objs_top; ++a)
-    {
-        if ((*a)->o_nrefs != 0)
-            mem += ici_mark(*a);
-    }
+/*
+ * Mark an old object again, so that anything it now references gets
+ * marked too.
+ */
+#define gc_remark(o)    (objof(o)->o_flags &= ~O_MARK, ici_mark(o))
 
+/*
+ * Append 'o' to the collector list 'l'.  If we can't get the memory the
+ * list is incomplete, so the next collection must be a major one (which
+ * doesn't use it), and we return 1.
+ */
+static int
+gc_list_add(gclist_t *l, ici_obj_t *o)
+{
+    ici_obj_t           **n;
+    ptrdiff_t           oldz;
+    ptrdiff_t           newz;
 
-#if 0
-    /*
-     * Count how many atoms are going to be retained and how many are
-     * going to be lost so we can decide on the fastest method.
-     */
-    ndead_atoms = 0;
-    for (a = objs; a < objs_top; ++a)
+    if (l->l_top < l->l_limit)
     {
-        if (((*a)->o_flags & (O_ATOM|O_MARK)) == O_ATOM)
-            ++ndead_atoms;
+        *l->l_top++ = o;
+        return 0;
     }
-
-    /*
-     * Collection phase.  Discard unmarked objects, compact down marked
-     * objects and fix up the atom pool.
-     *
-     * Deleteing an atom from the atom pool is (say) once as expensive
-     * as adding one.  Use this to determine which is quicker; rebuilding
-     * the atom pool or deleting dead ones.
-     */
-    if (ndead_atoms > (ici_natoms - ndead_atoms))
+    oldz = l->l_limit - l->l_base;
+    newz = oldz == 0 ? 256 : oldz * 2;
+    if ((n = (ici_obj_t **)ici_nalloc(newz * sizeof(ici_obj_t *))) == NULL)
     {
-        /*
-         * Rebuilding the atom pool is a better idea. Zap the dead
-         * atoms in the atom pool (thus breaking it) then rebuild
-         * it (which doesn't care it isn't a hash table any more).
-         */
-        a = &atoms[atomsz];
-        while (--a >= atoms)
-        {
-            if ((o = *a) != NULL && o->o_nrefs == 0 && (o->o_flags & O_MARK) == 0)
-                *a = NULL;
-        }
-        ici_natoms -= ndead_atoms;
-        /*
-         * Call ici_grow_atoms() to reuild the atom pool. On entry it isn't
-         * a legal hash table, but ici_grow_atoms() doesn't care. We make the
-         * new one the same size as the old one. Should we?
-         */
-        if (ici_natoms * 4 > atomsz)
-            atomsz *= 4;
-        ici_grow_atoms_core(atomsz);
-
-        for (a = b = objs; a < objs_top; ++a)
-        {
-            if (((o = *a)->o_flags & O_MARK) == 0)
-            {
-                freeo(o);
-            }
-            else
-            {
-                o->o_flags &= ~O_MARK;
-                *b++ = o;
-            }
-        }
-        objs_top = b;
+        gc_need_major = 1;
+        return 1;
     }
-    else
-#endif
+    if (oldz != 0)
     {
-        /*
-         * Faster to delete dead atoms as we go.
-         */
-        for (a = b = objs; a < objs_top; ++a)
-        {
-            if (((o = *a)->o_flags & O_MARK) == 0)
-            {
-                if ((o->o_flags & O_ATOM) == 0 || unatom(o) == 0)
-                    freeo(o);
-            }
-            else
-            {
-                o->o_flags &= ~O_MARK;
-                *b++ = o;
-            }
-        }
-        objs_top = b;
+        memcpy((char *)n, (char *)l->l_base, oldz * sizeof(ici_obj_t *));
+        ici_nfree(l->l_base, oldz * sizeof(ici_obj_t *));
     }
-/*
-printf("mem=%ld vs. %ld, nobjects=%d, ici_natoms=%d\n", mem, ici_mem_used, objs_top - objs, ici_natoms);
-*/
-    /*
-     * Set ici_mem_limit (which is the point at which to trigger a
-     * new call to us) to twice what is currently allocated, but
-     * with a special cases for small sizes.
-     */
-    if (ici_mem_used < 0)
-        ici_mem_used = 0;
-#   if ALLCOLLECT
-        ici_mem_limit = 0;
-#   else
-        if (ici_mem_used < 16 * 1024)
-            ici_mem_limit = 32 * 1024;
-        else
-            ici_mem_limit = ici_mem_used * 2;
-#   endif
-    --ici_supress_collect;
+    l->l_top = n + oldz;
+    l->l_base = n;
+    l->l_limit = n + newz;
+    *l->l_top++ = o;
+    return 0;
 }
 
-#ifndef NDEBUG
-void
-ici_dump_refs(void)
+static void
+gc_list_free(gclist_t *l)
 {
-    ici_obj_t           **a;
-    char                n[30];
-
-    if (objs_top > objs + 3)
-    {
-        printf("The following registered objects have not been freed...\n");
-        for (a = objs; a < objs_top; ++a)
-            if (*a != objof(&ici_xs) && *a != objof(&ici_os) && *a != objof(&ici_vs))
-                printf("%d 0x%08lX: %s\n", (*a)->o_nrefs, (unsigned long)*a, ici_objname(n, *a));
-    }
+    if (l->l_base != NULL)
+        ici_nfree(l->l_base, (l->l_limit - l->l_base) * sizeof(ici_obj_t *));
+    l->l_base = NULL;
+    l->l_top = NULL;
+    l->l_limit = NULL;
 }
-#endif
 
 /*
- * Garbage collection triggered by other than our internal mechanmism.
- * Don't do this unless you really must. It will free all memory it can
- * but will reduce subsequent performance.
+ * Return the slot of gc_frozen_set that holds the frozen object 'o', or
+ * the empty one it would go in.
  */
-void
-ici_reclaim(void)
+static ici_obj_t **
+gc_frozen_slot(ici_obj_t *o)
 {
-    collect();
-}
+    register ici_obj_t  **e;
 
+    for
+    (
+        e = &gc_frozen_set[ICI_PTR_HASH(o) & (gc_frozen_setz - 1)];
+        *e != NULL && gc_frozen_obj(*e) != o;
+        --e < gc_frozen_set ? e = gc_frozen_set + gc_frozen_setz - 1 : NULL
+    )
+        ;
+    return e;
+}
 
-#ifdef  BUGHUNT
+/*
+ * Return non-zero if 'o' is in the frozen generation and not thawed.
+ */
+static int
+gc_is_frozen(ici_obj_t *o)
+{
+    ici_obj_t           *e;
 
-ici_obj_t   *traceobj;
+    return (e = *gc_frozen_slot(o)) != NULL && !gc_is_thawed(e);
+}
 
-void
+/*
+ * Mark again the frozen objects that have been changed (thawed), first
+ * finding them afresh if more have been since we last looked.  These are
+ * the only frozen objects a collection looks in.
+ */
+static long
+gc_remark_thawed(void)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  **e;
+    long                mem;
+
+    mem = 0;
+    if (gc_thawing)
+    {
+        gc_thawing = 0;
+        gc_thawed.l_top = gc_thawed.l_base;
+        e = gc_frozen_set + gc_frozen_setz;
+        for (a = gc_frozen_set; a < e; ++a)
+        {
+            if
+            (
+                *a != NULL
+                &&
+                gc_is_thawed(*a)
+                &&
+                gc_list_add(&gc_thawed, gc_frozen_obj(*a))
+            )
+            {
+                /*
+                 * Can't keep the list.  Look through them all this time.
+                 */
+                gc_thawing = 1;
+                for (a = gc_frozen_set; a < e; ++a)
+                {
+                    if (*a != NULL && gc_is_thawed(*a))
+                        mem += gc_remark(gc_frozen_obj(*a));
+                }
+                return mem;
+            }
+        }
+    }
+    for (a = gc_thawed.l_base; a < gc_thawed.l_top; ++a)
+        mem += gc_remark(*a);
+    return mem;
+}
+
+/*
+ * The time, in seconds, by which the steps of an incremental collection are
+ * measured.  When marking is shared between threads this must be the time
+ * that passes, not the processor time used (which the helpers add to).
+ */
+#ifdef GC_PARALLEL
+static double
+gc_clock(void)
+{
+    struct timeval      tv;
+
+    if (ici_gc_threads <= 0)
+        return clock() / (double)CLOCKS_PER_SEC;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+#else
+#define gc_clock()      (clock() / (double)CLOCKS_PER_SEC)
+#endif
+
+#ifdef GC_PARALLEL
+/*
+ * Parallel marking.  When ici_gc_threads is non-zero, marking is shared
+ * between the collecting thread and that many helper threads.  Each has its
+ * own stack of marked objects still to be looked in (its part of the grey
+ * list), and takes work from the others when it runs out.  An object is
+ * claimed by whoever sets its O_MARK first, which is done atomically (see
+ * gc_par_push()).
+ *
+ * The helpers only run the mark functions of the core types, which do
+ * nothing but read objects and mark what they reference.  Objects of types
+ * registered by extensions are put aside for the collecting thread to mark
+ * in the ordinary way once the helpers have stopped.  Nothing that
+ * allocates or frees is done by the helpers, so the rest of the interpreter
+ * need not be thread safe for this.  For the same reason their stacks are
+ * got from malloc() directly.
+ */
+#define GC_MAX_THREADS  16
+#define GC_PAR_MIN      (4 * GC_QUANTUM)        /* Grey objects worth sharing. */
+#define GC_PAR_HEAP     (64 * 1024)             /* Objects worth sharing. */
+#define GC_PAR_STEAL    GC_QUANTUM              /* Most taken from another. */
+
+#define GC_PAR_CLEAR    0       /* Clear the marks in each slice of objs[]. */
+#define GC_PAR_MARK     1       /* Mark from the roots in each, and on. */
+
+typedef struct gcworker gcworker_t;
+struct gcworker
+{
+    ici_obj_t           **w_base;       /* Objects still to be looked in. */
+    ici_obj_t           **w_top;
+    ici_obj_t           **w_limit;
+    volatile int        w_lock;         /* Guards the above. */
+    ptrdiff_t           w_lo;           /* This one's slice of objs[]. */
+    ptrdiff_t           w_hi;
+    unsigned            w_gen;          /* Last run of a helper. */
+    pthread_t           w_thread;
+};
+
+static gcworker_t       gc_workers[GC_MAX_THREADS + 1]; /* [0] is us. */
+static gcworker_t       gc_aside;       /* Objects of extension types. */
+static int              gc_nhelpers;    /* Helper threads started. */
+static pid_t            gc_helpers_pid; /* The process that started them. */
+static int              gc_nactive;     /* Workers in this run, or 0. */
+static int              gc_par_job;     /* One of GC_PAR_* above. */
+static int              gc_par_all;     /* Ignore gc_par_deadline. */
+static double           gc_par_deadline;
+static volatile int     gc_par_idle;    /* Workers out of work. */
+static volatile int     gc_par_stop;    /* Out of time, stop now. */
+static volatile int     gc_par_failed;  /* An object couldn't be pushed. */
+static int              gc_par_running; /* Helpers still in this run. */
+static unsigned         gc_par_gen;     /* Bumped to start each run. */
+static int              gc_par_quit;    /* Helpers are to exit. */
+static int              gc_par_keyed;   /* gc_par_key has been made. */
+static pthread_key_t    gc_par_key;     /* Each thread's gc_workers[]. */
+static pthread_mutex_t  gc_par_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   gc_par_go = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   gc_par_done = PTHREAD_COND_INITIALIZER;
+
+#define gc_par_lock(w)  do { while (__sync_lock_test_and_set(&(w)->w_lock, 1)) \
+                                while ((w)->w_lock) sched_yield(); } while (0)
+#define gc_par_unlock(w) __sync_lock_release(&(w)->w_lock)
+
+/*
+ * Is w's stack empty?  Without the lock this is only a hint.
+ */
+#define gc_par_empty(w) (*(ici_obj_t **volatile *)&(w)->w_top == (w)->w_base)
+
+/*
+ * Is there enough on the grey list to be worth sharing out?
+ */
+#define gc_par_worth()  (ici_gc_threads > 0 \
+                        && gc_grey.l_top - gc_grey.l_base >= GC_PAR_MIN)
+
+/*
+ * Is the heap big enough for a major collection to be worth sharing out?
+ */
+#define gc_par_heap()   (ici_gc_threads > 0 && objs_top - objs >= GC_PAR_HEAP)
+
+/*
+ * Claim the object 'o' for the worker 'w' and push it on w's stack.  If
+ * another worker got there first there is nothing to do.  If the stack
+ * can't be grown the object is left unmarked and gc_par_failed set.
+ */
+static void
+gc_par_push(gcworker_t *w, ici_obj_t *o)
+{
+    ici_obj_t           **n;
+    ptrdiff_t           z;
+
+    if ((__sync_fetch_and_or(&o->o_flags, O_MARK) & O_MARK) != 0)
+        return;
+    if (o->o_tcode > TC_MAX_CORE)
+        w = &gc_aside;
+    gc_par_lock(w);
+    if (w->w_top == w->w_limit)
+    {
+        z = w->w_limit - w->w_base;
+        z = z == 0 ? 1024 : z * 2;
+        if ((n = (ici_obj_t **)realloc(w->w_base, z * sizeof(ici_obj_t *))) == NULL)
+        {
+            gc_par_unlock(w);
+            __sync_fetch_and_and(&o->o_flags, ~O_MARK);
+            gc_par_failed = 1;
+            return;
+        }
+        w->w_top = n + (w->w_top - w->w_base);
+        w->w_base = n;
+        w->w_limit = n + z;
+    }
+    *w->w_top++ = o;
+    gc_par_unlock(w);
+}
+
+static ici_obj_t *
+gc_par_pop(gcworker_t *w)
+{
+    ici_obj_t           *o;
+
+    if (gc_par_empty(w))
+        return NULL;
+    o = NULL;
+    gc_par_lock(w);
+    if (w->w_top > w->w_base)
+        o = *--w->w_top;
+    gc_par_unlock(w);
+    return o;
+}
+
+/*
+ * Take up to half of what another worker has still to do, and do it.
+ * Returns 0 if there was nothing to take.
+ */
+static int
+gc_par_steal(gcworker_t *w)
+{
+    ici_obj_t           *take[GC_PAR_STEAL];
+    gcworker_t          *v;
+    ptrdiff_t           n;
+    int                 i;
+
+    for (i = 1; i < gc_nactive; ++i)
+    {
+        v = &gc_workers[(w - gc_workers + i) % gc_nactive];
+        if (gc_par_empty(v))
+            continue;
+        gc_par_lock(v);
+        if ((n = (v->w_top - v->w_base + 1) / 2) > GC_PAR_STEAL)
+            n = GC_PAR_STEAL;
+        v->w_top -= n;
+        memcpy((char *)take, (char *)v->w_top, n * sizeof(ici_obj_t *));
+        gc_par_unlock(v);
+        if (n == 0)
+            continue;
+        while (--n >= 0)
+            (*ici_typeof(take[n])->t_mark)(take[n]);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Look in the objects on w's stack, and those taken from others, until
+ * there are none left anywhere, or we are told to stop.  Only the
+ * collecting thread looks at the clock.
+ */
+static void
+gc_par_mark(gcworker_t *w)
+{
+    ici_obj_t           *o;
+    long                n;
+    int                 i;
+
+    for (n = 0; ; )
+    {
+        while ((o = gc_par_pop(w)) != NULL || gc_par_steal(w))
+        {
+            if (o != NULL)
+                (*ici_typeof(o)->t_mark)(o);
+            if
+            (
+                (++n & (GC_QUANTUM - 1)) == 0
+                &&
+                w == gc_workers
+                &&
+                !gc_par_all
+                &&
+                gc_clock() >= gc_par_deadline
+            )
+                gc_par_stop = 1;
+            if (gc_par_stop)
+                return;
+        }
+        /*
+         * Our stack stays empty while we are idle, so once all are idle
+         * there is nothing left to do.
+         */
+        __sync_fetch_and_add(&gc_par_idle, 1);
+        for (;;)
+        {
+            if (gc_par_idle == gc_nactive || gc_par_stop)
+                return;
+            for (i = 0; i < gc_nactive && gc_par_empty(&gc_workers[i]); ++i)
+                ;
+            if (i < gc_nactive)
+                break;
+            sched_yield();
+        }
+        __sync_fetch_and_sub(&gc_par_idle, 1);
+    }
+}
+
+/*
+ * Do w's part of the current run.
+ */
+static void
+gc_par_work(gcworker_t *w)
+{
+    ici_obj_t           **a;
+    ici_obj_t           **e;
+
+    e = objs + w->w_hi;
+    if (gc_par_job == GC_PAR_CLEAR)
+    {
+        for (a = objs + w->w_lo; a < e; ++a)
+            (*a)->o_flags &= ~O_MARK;
+        return;
+    }
+    for (a = objs + w->w_lo; a < e; ++a)
+    {
+        if ((*a)->o_nrefs != 0)
+            ici_mark(*a);
+    }
+    gc_par_mark(w);
+}
+
+static void *
+gc_par_helper(void *arg)
+{
+    gcworker_t          *w;
+    sigset_t            all;
+
+    /*
+     * Signals are for the interpreter's threads, not us.
+     */
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, NULL);
+    w = (gcworker_t *)arg;
+    pthread_setspecific(gc_par_key, w);
+    pthread_mutex_lock(&gc_par_mutex);
+    for (;;)
+    {
+        while (w->w_gen == gc_par_gen && !gc_par_quit)
+            pthread_cond_wait(&gc_par_go, &gc_par_mutex);
+        if (gc_par_quit)
+            break;
+        w->w_gen = gc_par_gen;
+        if (w - gc_workers >= gc_nactive)
+            continue;
+        pthread_mutex_unlock(&gc_par_mutex);
+        gc_par_work(w);
+        pthread_mutex_lock(&gc_par_mutex);
+        if (--gc_par_running == 0)
+            pthread_cond_signal(&gc_par_done);
+    }
+    pthread_mutex_unlock(&gc_par_mutex);
+    return NULL;
+}
+
+/*
+ * Start as many of the ici_gc_threads helper threads as are not yet
+ * running.  Returns the number that can be used.
+ */
+static int
+gc_par_start(void)
+{
+    gcworker_t          *w;
+    int                 n;
+
+    if ((n = ici_gc_threads) > GC_MAX_THREADS)
+        n = GC_MAX_THREADS;
+    if (n <= 0)
+        return 0;
+    if (gc_nhelpers != 0 && gc_helpers_pid != getpid())
+    {
+        /*
+         * We are a child forked by the process that started the helpers.
+         * They don't come with us.
+         */
+        gc_nhelpers = 0;
+        pthread_mutex_init(&gc_par_mutex, NULL);
+        pthread_cond_init(&gc_par_go, NULL);
+        pthread_cond_init(&gc_par_done, NULL);
+    }
+    if (!gc_par_keyed)
+    {
+        if (pthread_key_create(&gc_par_key, NULL) != 0)
+            return 0;
+        gc_par_keyed = 1;
+    }
+    while (gc_nhelpers < n)
+    {
+        w = &gc_workers[gc_nhelpers + 1];
+        w->w_gen = gc_par_gen;
+        if (pthread_create(&w->w_thread, NULL, gc_par_helper, w) != 0)
+            break;
+        ++gc_nhelpers;
+        gc_helpers_pid = getpid();
+    }
+    return n < gc_nhelpers ? n : gc_nhelpers;
+}
+
+/*
+ * Stop the helper threads and free the workers' stacks.
+ */
+static void
+gc_par_uninit(void)
+{
+    gcworker_t          *w;
+    int                 i;
+
+    if (gc_nhelpers != 0 && gc_helpers_pid == getpid())
+    {
+        pthread_mutex_lock(&gc_par_mutex);
+        gc_par_quit = 1;
+        pthread_cond_broadcast(&gc_par_go);
+        pthread_mutex_unlock(&gc_par_mutex);
+        for (i = 1; i <= gc_nhelpers; ++i)
+            pthread_join(gc_workers[i].w_thread, NULL);
+        gc_par_quit = 0;
+    }
+    gc_nhelpers = 0;
+    for (i = 0; i <= GC_MAX_THREADS + 1; ++i)
+    {
+        w = i <= GC_MAX_THREADS ? &gc_workers[i] : &gc_aside;
+        free(w->w_base);
+        w->w_base = w->w_top = w->w_limit = NULL;
+    }
+}
+
+/*
+ * Do the job 'job' (one of GC_PAR_* above) with the helpers, each worker
+ * taking an equal slice of objs[lo..hi).  Marking goes on from what is on
+ * the grey list until there is nothing left to do or, unless 'all' is set,
+ * the time is past 'deadline'.  What is left, and any objects of extension
+ * types, are put back on the grey list.  Returns 1, having done nothing,
+ * if there are no helpers.
+ */
+static int
+gc_par_run(int job, ptrdiff_t lo, ptrdiff_t hi, int all, double deadline)
+{
+    gcworker_t          *w;
+    ici_obj_t           **a;
+    ici_obj_t           **n;
+    ptrdiff_t           z;
+    int                 nhelpers;
+    int                 defer;
+    int                 i;
+
+    if ((nhelpers = gc_par_start()) == 0)
+        return 1;
+    w = gc_workers;
+    if ((z = gc_grey.l_top - gc_grey.l_base) > w->w_limit - w->w_base)
+    {
+        if ((n = (ici_obj_t **)realloc(w->w_base, z * sizeof(ici_obj_t *))) == NULL)
+            return 1;
+        w->w_base = n;
+        w->w_limit = n + z;
+    }
+    memcpy((char *)w->w_base, (char *)gc_grey.l_base, z * sizeof(ici_obj_t *));
+    w->w_top = w->w_base + z;
+    gc_grey.l_top = gc_grey.l_base;
+    for (i = 0; i <= nhelpers; ++i)
+    {
+        gc_workers[i].w_lo = lo + (hi - lo) * i / (nhelpers + 1);
+        gc_workers[i].w_hi = lo + (hi - lo) * (i + 1) / (nhelpers + 1);
+    }
+    gc_nactive = nhelpers + 1;
+    gc_par_job = job;
+    gc_par_all = all;
+    gc_par_deadline = deadline;
+    gc_par_idle = 0;
+    gc_par_stop = 0;
+    gc_par_failed = 0;
+    defer = ici_gc_defer;
+    ici_gc_defer = 1;
+    pthread_setspecific(gc_par_key, w);
+
+    pthread_mutex_lock(&gc_par_mutex);
+    gc_par_running = nhelpers;
+    ++gc_par_gen;
+    pthread_cond_broadcast(&gc_par_go);
+    pthread_mutex_unlock(&gc_par_mutex);
+    gc_par_work(w);
+    pthread_mutex_lock(&gc_par_mutex);
+    while (gc_par_running != 0)
+        pthread_cond_wait(&gc_par_done, &gc_par_mutex);
+    pthread_mutex_unlock(&gc_par_mutex);
+
+    pthread_setspecific(gc_par_key, NULL);
+    gc_nactive = 0;
+    for (i = 0; i <= nhelpers + 1; ++i)
+    {
+        w = i <= nhelpers ? &gc_workers[i] : &gc_aside;
+        while (w->w_top > w->w_base)
+            ici_mark_defer(*--w->w_top);
+    }
+    if (gc_par_failed)
+    {
+        /*
+         * Some object that should be marked may not be.  Look again in
+         * everything that is.
+         */
+        ici_gc_defer = 0;
+        for (a = objs + objs_nfrozen; a < objs_top; ++a)
+        {
+            if (((*a)->o_flags & O_MARK) != 0 && (*a)->o_leafz == 0)
+                gc_remark(*a);
+        }
+        gc_remark_thawed();
+    }
+    ici_gc_defer = defer;
+    return 0;
+}
+
+#else /* GC_PARALLEL */
+
+#define gc_par_worth()  0
+#define gc_par_heap()   0
+#define gc_par_run(job, lo, hi, all, deadline) 1
+
+#endif /* GC_PARALLEL */
+
+/*
+ * Add 'o' to the remembered set.  If it is full, during the marking phase
+ * of an incremental collection we mark what it holds now, in full, to make
+ * room.  Otherwise the set is incomplete and the next collection must be a
+ * major one.
+ */
+static void
+gc_remember_add(ici_obj_t *o)
+{
+    ici_obj_t           **a;
+    int                 defer;
+
+    if (gc_nremembered == nels(gc_remembered))
+    {
+        if (gc_phase != GC_MARK)
+        {
+            gc_need_major = 1;
+            return;
+        }
+        defer = ici_gc_defer;
+        ici_gc_defer = 0;
+        for (a = gc_remembered; a < gc_remembered + gc_nremembered; ++a)
+            ici_mark(*a);
+        ici_gc_defer = defer;
+        gc_nremembered = 0;
+    }
+    gc_remembered[gc_nremembered++] = o;
+}
+
+/*
+ * Record that the old object 'o' is being modified.  This is the slow
+ * path of the ici_wb() macro, which has already checked that 'o' is old.
+ * We clear its O_MARK so that the next minor collection marks through it
+ * and further stores into it don't come this way again.  This never
+ * allocates.
+ *
+ * While an incremental collection is marking, 'o' may already have been
+ * looked in, so clearing its O_MARK has it looked in again.  While one is
+ * sweeping, O_MARK is what says 'o' is to be kept, so that is left until
+ * the sweep is done.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_remember(ici_obj_t *o)
+{
+    if (objs_nfrozen != 0)
+    {
+        ici_obj_t       **e;
+
+        e = gc_frozen_slot(o);
+        if (*e != NULL && !gc_is_thawed(*e))
+        {
+            *e = (ici_obj_t *)((unsigned long)o | GC_THAWED);
+            gc_thawing = 1;
+        }
+    }
+    if (gc_phase == GC_SWEEP)
+    {
+        if (gc_nremembered > 0 && gc_remembered[gc_nremembered - 1] == o)
+            return;
+    }
+    else
+    {
+        o->o_flags &= ~O_MARK;
+        if (gc_phase == GC_CLEAR)
+            return;
+    }
+    gc_remember_add(o);
+}
+
+/*
+ * Note that a reference to 'o' is being held from C data while an
+ * incremental collection is marking.  The place 'o' was found may have
+ * been looked in already, or may lose it before it is looked in, so make
+ * sure it gets marked.  This is the slow path of ici_incref().  It never
+ * allocates.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_gc_shade(ici_obj_t *o)
+{
+    if
+    (
+        (o->o_flags & O_MARK) == 0
+        &&
+        (gc_nremembered == 0 || gc_remembered[gc_nremembered - 1] != o)
+    )
+        gc_remember_add(o);
+}
+
+/*
+ * The slow path of ici_mark() during a step of an incremental collection.
+ * Rather than recursing into 'o' now, we mark it and push it on the grey
+ * list for the collector to look in later.  If the list can't be grown, we
+ * mark through 'o' right now.  In a parallel run it goes on the calling
+ * worker's own stack instead.  While a heap dump is being taken (see
+ * ici_heap_dump()) it is just noted as referenced.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+unsigned long
+ici_mark_defer(ici_obj_t *o)
+{
+    unsigned long       mem;
+    int                 need_major;
+#ifdef GC_PARALLEL
+    gcworker_t          *w;
+#endif
+
+    if (gc_dumping)
+    {
+        if (gc_list_add(&gc_dump_refs, o))
+            gc_dump_failed = 1;
+        return 0;
+    }
+#ifdef GC_PARALLEL
+    if (gc_nactive != 0 && (w = (gcworker_t *)pthread_getspecific(gc_par_key)) != NULL)
+    {
+        gc_par_push(w, o);
+        return 0;
+    }
+#endif
+
+    need_major = gc_need_major;
+    if (gc_list_add(&gc_grey, o) == 0)
+    {
+        o->o_flags |= O_MARK;
+        return 0;
+    }
+    gc_need_major = need_major;
+    ici_gc_defer = 0;
+    mem = (*ici_typeof(o)->t_mark)(o);
+    ici_gc_defer = 1;
+    return mem;
+}
+
+/*
+ * Re-mark the stacks of every exec.  These are modified directly all the
+ * time by the interpreter and are not subject to the write barrier.
+ */
+static long
+gc_remark_stacks(void)
+{
+    ici_exec_t          *x;
+    long                mem;
+
+    mem = 0;
+    if (ici_exec != NULL)
+        mem += gc_remark(&ici_xs) + gc_remark(&ici_os) + gc_remark(&ici_vs);
+    for (x = ici_execs; x != NULL; x = x->x_next)
+    {
+        if (x->x_xs != NULL)
+            mem += gc_remark(x->x_xs);
+        if (x->x_os != NULL)
+            mem += gc_remark(x->x_os);
+        if (x->x_vs != NULL)
+            mem += gc_remark(x->x_vs);
+        if (x->x_pc_closet != NULL)
+            mem += gc_remark(x->x_pc_closet);
+        if (x->x_os_temp_cache != NULL)
+            mem += gc_remark(x->x_os_temp_cache);
+    }
+    return mem;
+}
+
+/*
+ * Sweep objs[gc_pos..gc_sweep_end), but no more than 'n' of them.  Unmarked
+ * objects are freed and the survivors compacted down to gc_sweep_to.
+ * Survivors keep their O_MARK, which makes them old, and those that later
+ * minor collections must look inside are added to the lists.
+ *
+ * An object with a non-zero nrefs is always kept.  Normally such an object
+ * has been marked anyway, but the thread switching code copies whole stack
+ * array headers about (see ici_enter()).
+ */
+static void
+gc_sweep_some(ptrdiff_t n)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  **b;
+    register ici_obj_t  **e;
+    register ici_obj_t  *o;
+
+    a = objs + gc_pos;
+    b = objs + gc_sweep_to;
+    e = n < gc_sweep_end - gc_pos ? a + n : objs + gc_sweep_end;
+    for (; a < e; ++a)
+    {
+        if (((o = *a)->o_flags & O_MARK) == 0 && o->o_nrefs == 0)
+        {
+            if ((o->o_flags & O_ATOM) == 0 || unatom(o) == 0)
+                freeo(o);
+        }
+        else
+        {
+            o->o_flags |= O_MARK;
+            *b++ = o;
+            if (gc_rescan(o))
+                gc_list_add(&gc_rescans, o);
+            else if (o->o_nrefs != 0 && gc_container(o) && (o->o_flags & O_ATOM) == 0)
+                gc_list_add(&gc_held, o);
+        }
+    }
+    gc_pos = a - objs;
+    gc_sweep_to = b - objs;
+}
+
+/*
+ * Finish a sweep.  Objects made while an incremental sweep was going on
+ * follow the survivors down, and they, and the objects the write barrier
+ * has noted, have their O_MARK cleared (see ici_remember()).
+ */
+static void
+gc_sweep_done(void)
+{
+    ptrdiff_t           n;
+    ici_obj_t           **a;
+
+    n = objs_top - (objs + gc_sweep_end);
+    if (n != 0 && gc_sweep_to != gc_sweep_end)
+        memmove(objs + gc_sweep_to, objs + gc_sweep_end, n * sizeof(ici_obj_t *));
+    objs_top = objs + gc_sweep_to + n;
+    objs_nold = gc_sweep_to;
+    for (a = objs + objs_nold; a < objs_top; ++a)
+        (*a)->o_flags &= ~O_MARK;
+    for (a = gc_remembered; a < gc_remembered + gc_nremembered; ++a)
+        (*a)->o_flags &= ~O_MARK;
+    ici_gc_sweeping = 0;
+    gc_phase = GC_IDLE;
+    /*
+     * Don't leave a big, sparse atom pool after a spike.
+     */
+    if (atomsz > 64 && ici_natoms * 8 < atomsz)
+        ici_grow_atoms_core(atoms_size_for(ici_natoms), 0);
+}
+
+/*
+ * Free the unmarked objects in objs[base..objs_top) and compact the
+ * survivors down, all at once.
+ */
+static void
+gc_sweep(ici_obj_t **base)
+{
+    gc_pos = gc_sweep_to = base - objs;
+    gc_sweep_end = objs_top - objs;
+    gc_sweep_some(gc_sweep_end - gc_pos);
+    gc_sweep_done();
+}
+
+/*
+ * Begin an incremental major collection.  Like an all at once one, it
+ * forgets the generations.  The remembered set and lists are of no use to
+ * it.
+ */
+static void
+gc_begin(void)
+{
+    gc_phase = GC_CLEAR;
+    gc_pos = objs_nfrozen;
+    gc_nremembered = 0;
+    gc_need_major = 0;
+}
+
+/*
+ * Clear the marks of up to 'n' more objects.
+ */
+static void
+gc_clear_some(ptrdiff_t n)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  **e;
+
+    a = objs + gc_pos;
+    e = n < objs_top - a ? a + n : objs_top;
+    for (; a < e; ++a)
+        (*a)->o_flags &= ~O_MARK;
+    gc_pos = a - objs;
+    if (a == objs_top)
+    {
+        gc_phase = GC_MARK;
+        gc_pos = objs_nfrozen;
+        ici_gc_marking = 1;
+        ici_gc_defer = 1;
+        gc_remark_thawed();
+        ici_gc_defer = 0;
+    }
+}
+
+/*
+ * Look in the next grey object, or mark the next remembered one.  Returns 0
+ * if there was none.
+ */
+static int
+gc_mark_one(void)
+{
+    ici_obj_t           *o;
+
+    if (gc_grey.l_top > gc_grey.l_base)
+    {
+        o = *--gc_grey.l_top;
+        o->o_flags &= ~O_MARK;
+        (*ici_typeof(o)->t_mark)(o);
+        return 1;
+    }
+    if (gc_nremembered > 0)
+    {
+        o = gc_remembered[--gc_nremembered];
+        ici_mark(o);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Look in everything on the grey list and in the remembered set, sharing
+ * the work with the helper threads while there is enough of it.
+ */
+static void
+gc_mark_all(void)
+{
+    do
+    {
+        if (gc_par_worth())
+            gc_par_run(GC_PAR_MARK, 0, 0, 1, 0.0);
+    }
+    while (gc_mark_one());
+}
+
+/*
+ * The end of the marking phase of an incremental collection.  This is done
+ * all at once.  We mark again those things the program may have changed
+ * without the write barrier, much as a minor collection does.  That is, the
+ * stacks, objects of unbarriered types and held arrays, structs and sets,
+ * and everything that is young.  Then we finish marking and set up the
+ * sweep.
+ */
+static void
+gc_mark_done(void)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  *o;
+
+    for (a = objs + objs_nold; a < objs_top; ++a)
+    {
+        o = *a;
+        if (o->o_nrefs != 0 || (gc_rescan(o) && (o->o_flags & O_MARK) != 0))
+            gc_remark(o);
+    }
+    for (a = gc_held.l_base; a < gc_held.l_top; ++a)
+    {
+        if ((*a)->o_nrefs != 0)
+            gc_remark(*a);
+    }
+    for (a = gc_rescans.l_base; a < gc_rescans.l_top; ++a)
+    {
+        if (((*a)->o_flags & O_MARK) != 0)
+            gc_remark(*a);
+    }
+    gc_remark_stacks();
+    gc_remark_thawed();
+    gc_mark_all();
+    ici_gc_marking = 0;
+
+    gc_held.l_top = gc_held.l_base;
+    gc_rescans.l_top = gc_rescans.l_base;
+    gc_phase = GC_SWEEP;
+    ici_gc_sweeping = 1;
+    gc_pos = gc_sweep_to = objs_nfrozen;
+    gc_sweep_end = objs_top - objs;
+}
+
+/*
+ * Do up to 'n' units of marking work.  Roots are the objects with a
+ * non-zero nrefs, found by a pass over objs[].
+ */
+static void
+gc_mark_some(ptrdiff_t n)
+{
+    ici_obj_t           *o;
+
+    ici_gc_defer = 1;
+    while (--n >= 0)
+    {
+        if (gc_mark_one())
+            continue;
+        if (objs + gc_pos < objs_top)
+        {
+            o = objs[gc_pos++];
+            if (o->o_nrefs != 0)
+                ici_mark(o);
+            continue;
+        }
+        gc_mark_done();
+        break;
+    }
+    ici_gc_defer = 0;
+}
+
+/*
+ * Do a step of an incremental major collection, taking about ici_gc_pause
+ * microseconds, or until it is finished if 'all' is set.  Some progress is
+ * always made.
+ */
+static void
+gc_step(int all)
+{
+    double              deadline;
+
+    deadline = gc_clock() + ici_gc_pause / 1e6;
+    do
+    {
+        switch (gc_phase)
+        {
+        case GC_CLEAR:
+            gc_clear_some(16 * GC_QUANTUM);
+            break;
+
+        case GC_MARK:
+            if (gc_par_worth())
+                gc_par_run(GC_PAR_MARK, 0, 0, all, deadline);
+            gc_mark_some(GC_QUANTUM);
+            break;
+
+        case GC_SWEEP:
+            gc_sweep_some(GC_QUANTUM);
+            if (gc_pos == gc_sweep_end)
+                gc_sweep_done();
+            break;
+        }
+    }
+    while (gc_phase != GC_IDLE && (all || gc_clock() < deadline));
+}
+
+/*
+ * Before objs[base..objs_top) is swept, count the atoms in it that are to
+ * be freed.  Normally the sweep deletes these from the atom pool one at a
+ * time (see unatom()), which is quick while they are few.  But when more
+ * atoms die than survive, as when a burst of work has made many transient
+ * strings and numbers, it is quicker to build the pool afresh without them,
+ * and at the right size for those left.
+ */
+static void
+gc_drop_dead_atoms(ici_obj_t **base)
+{
+    register ici_obj_t  **a;
+    register long       ndead;
+
+    ndead = 0;
+    for (a = base; a < objs_top; ++a)
+    {
+        if (((*a)->o_flags & (O_ATOM|O_MARK)) == O_ATOM && (*a)->o_nrefs == 0)
+            ++ndead;
+    }
+    if (ndead > ici_natoms - ndead)
+        ici_grow_atoms_core(atoms_size_for(ici_natoms - ndead), 1);
+}
+
+/*
+ * Do a whole collection, minor or major, at once.
+ */
+static void
+gc_all_at_once(int major)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  **b;
+    register long       mem;    /* Total mem tied up in refed objects. */
+
+    mem = 0;
+    if (major)
+    {
+        /*
+         * Forget the generations. Clear all marks, then mark all objects
+         * which are referenced (and thus what they ref).  A big heap is
+         * shared out between the helper threads, if there are any.
+         */
+        if
+        (
+            !gc_par_heap()
+            ||
+            gc_par_run(GC_PAR_CLEAR, objs_nfrozen, objs_top - objs, 1, 0.0) != 0
+        )
+        {
+            for (a = objs + objs_nfrozen; a < objs_top; ++a)
+                (*a)->o_flags &= ~O_MARK;
+        }
+        if
+        (
+            !gc_par_heap()
+            ||
+            gc_par_run(GC_PAR_MARK, objs_nfrozen, objs_top - objs, 1, 0.0) != 0
+        )
+        {
+            for (a = objs + objs_nfrozen; a < objs_top; ++a)
+            {
+                if ((*a)->o_nrefs != 0)
+                    mem += ici_mark(*a);
+            }
+            mem += gc_remark_stacks();
+            mem += gc_remark_thawed();
+        }
+        else
+        {
+            gc_nremembered = 0;
+            ici_gc_defer = 1;
+            gc_remark_stacks();
+            gc_remark_thawed();
+            gc_mark_all();
+            ici_gc_defer = 0;
+        }
+        gc_held.l_top = gc_held.l_base;
+        gc_rescans.l_top = gc_rescans.l_base;
+        objs_nold = objs_nfrozen;
+    }
+    else
+    {
+        for (a = objs + objs_nold; a < objs_top; ++a)
+        {
+            if ((*a)->o_nrefs != 0)
+                mem += ici_mark(*a);
+        }
+        /*
+         * Re-mark the held old objects.  Those that are no longer held are
+         * dropped from the list as we go.
+         */
+        for (a = b = gc_held.l_base; a < gc_held.l_top; ++a)
+        {
+            mem += gc_remark(*a);
+            if ((*a)->o_nrefs != 0)
+                *b++ = *a;
+        }
+        gc_held.l_top = b;
+        for (a = gc_rescans.l_base; a < gc_rescans.l_top; ++a)
+            mem += gc_remark(*a);
+        mem += gc_remark_stacks();
+        mem += gc_remark_thawed();
+        for (a = gc_remembered; a < gc_remembered + gc_nremembered; ++a)
+            mem += ici_mark(*a);
+    }
+    gc_nremembered = 0;
+    gc_need_major = 0;
+
+    gc_drop_dead_atoms(objs + objs_nold);
+    gc_sweep(objs + objs_nold);
+/*
+printf("mem=%ld vs. %ld, nobjects=%d, ici_natoms=%d\n", mem, ici_mem_used, objs_top - objs, ici_natoms);
+*/
+}
+
+/*
+ * Account for the time spent in a call of collect() that began at 'start'
+ * by gc_clock() and 'cpu' by clock().
+ */
+static void
+gc_account(double start, clock_t cpu)
+{
+    double              t;
+
+    t = gc_clock() - start;
+    gc_pause_total += t;
+    if (t > gc_pause_max)
+        gc_pause_max = t;
+    if (ici_gc_cpu > 0)
+        gc_cpu_used += clock() - cpu;
+}
+
+/*
+ * Set gc_old_limit, the point at which the next major collection is due, at
+ * the end of a major collection, according to the policy given by the
+ * ici_gc_* variables above.
+ */
+static void
+gc_set_old_limit(void)
+{
+    double              limit;
+    double              least;
+    clock_t             now;
+
+    if (ici_gc_growth < 1.0)
+        ici_gc_growth = 1.0;
+    if (ici_gc_cpu <= 0)
+        gc_growth = ici_gc_growth;
+    else
+    {
+        now = clock();
+        if (now != (clock_t)-1 && now > gc_cpu_mark)
+        {
+            if (gc_cpu_used > ici_gc_cpu * (now - gc_cpu_mark))
+            {
+                gc_growth *= 1.5;
+                if (gc_growth > 16 * ici_gc_growth)
+                    gc_growth = 16 * ici_gc_growth;
+            }
+            else if (gc_cpu_used < ici_gc_cpu / 2 * (now - gc_cpu_mark))
+                gc_growth /= 1.5;
+        }
+        if (gc_growth < ici_gc_growth)
+            gc_growth = ici_gc_growth;
+        gc_cpu_mark = now;
+        gc_cpu_used = 0;
+    }
+    limit = ici_mem_used * gc_growth;
+    if (ici_gc_max_heap > 0 && limit > ici_gc_max_heap)
+    {
+        least = ici_mem_used * (1 + (gc_growth - 1) / 4);
+        limit = least > ici_gc_max_heap ? least : ici_gc_max_heap;
+    }
+    if (limit < ici_gc_min_heap)
+        limit = ici_gc_min_heap;
+    gc_old_limit = limit < LONG_MAX ? (long)limit : LONG_MAX;
+}
+
+/*
+ * Generational mark sweep garbage collection.  Should be safe to do any
+ * time, as new objects are created without the nrefs == 0 which allows
+ * them to be collected.  They must be explicitly lost before they are
+ * subject to garbage collection.  But of course all code must be careful
+ * not to hang on to "found" objects where they are not accessible, or they
+ * will be collected.  You can ici_incref() them if you want.  All "held"
+ * objects will cause all objects referenced from them to be marked (ie, not
+ * collected), as long as they are registered on either the global object
+ * list or in the atom pool.  Thus statically declared objects which
+ * reference other objects (very rare) must be appropriately registered.
+ *
+ * Registered objects that have survived a collection are "old" and occupy
+ * objs[0..objs_nold).  They keep their O_MARK flag set between collections.
+ * Most collections are "minor".  They start marking from the roots given
+ * below and, as old objects are already marked, only reach young objects.
+ * They then sweep just the young part of objs[], and so take time in
+ * proportion to the amount of new and surviving data, not the total heap.
+ * When the heap has grown enough since the last one (or the lists below are
+ * not trustworthy), a "major" collection clears all marks and does a full
+ * mark and sweep, as this collector always used to do.
+ *
+ * The roots of a minor collection are:
+ *
+ *  - young objects with a non-zero nrefs;
+ *
+ *  - old arrays, structs and sets that had a non-zero nrefs when they were
+ *    last seen by a collection (gc_held).  C code fills in objects it has
+ *    just made with direct stores, without the write barrier;
+ *
+ *  - old objects of types which are not subject to the write barrier
+ *    (gc_rescans);
+ *
+ *  - the stacks of every exec;
+ *
+ *  - old objects modified since the last collection, as recorded by the
+ *    write barrier ici_wb() (the remembered set).
+ *
+ * All of these are marked again, to pick up whatever they now reference.
+ * So a minor collection also takes time in proportion to the depth of the
+ * stacks and the size of each changed object (all of a big array is looked
+ * at again when one element is set), however little was made.  To keep
+ * this a small part of the work, the nursery (what may be allocated before
+ * the next minor collection) is an eighth of the heap, or GC_NURSERY if
+ * that is more.
+ *
+ * Unless ici_gc_pause is zero, a major collection is incremental.  It is
+ * done in steps, each of about ici_gc_pause microseconds, taken each time
+ * another GC_STEP of memory has been allocated.  It first clears all marks,
+ * then marks from objects with a non-zero nrefs, using the grey list rather
+ * than recursion (see ici_mark_defer()), then frees what wasn't marked.
+ * While it is marking, the write barrier clears the mark of a changed
+ * object so that it is looked in again, and ici_incref() has newly held
+ * objects marked.  What the barrier doesn't cover is marked again in one
+ * go at the end of the marking (see gc_mark_done()).  While it is sweeping,
+ * atoms found to be garbage are passed over by lookups in the atom pool.
+ * Should the program allocate so fast that the heap doubles before a major
+ * collection is done, the rest of it is done at once.
+ *
+ * If ici_gc_threads is set, the marking of a major collection, whether
+ * done at once or in steps, is shared with that many helper threads
+ * whenever there is enough of it (see gc_par_run()).  Sweeping is still
+ * done by this thread alone, as freeing goes through the allocator and the
+ * atom pool, which are not thread safe.
+ *
+ * Below all of these, objs[0..objs_nfrozen) is the frozen generation made
+ * by ici_gc_freeze().  No collection touches it, except to look in those
+ * frozen objects that have been thawed by a change.
+ */
+void
+collect(void)
+{
+    int                 major;
+    double              start;
+    clock_t             cpu;
+
+    if (ici_supress_collect)
+    {
+        /*
+         * There are some times when it is a bad idea to collect. Basically
+         * when we are allocating, or fiddling with, basic data structures like
+         * the atom pool and object list; and during recursive calls.
+         */
+        return;
+    }
+    ++ici_supress_collect;
+    start = gc_clock();
+    cpu = ici_gc_cpu > 0 ? clock() : 0;
+
+#   ifndef NDEBUG
+    /*
+     * In debug builds we take this opportunity to check the consistency of of
+     * the atom pool.  We check that each entry has the O_ATOM flag set, and
+     * that it can be found in the pool (i.e.  that its hash is the same as
+     * when it was inserted).  A failure here is a common result of a hash
+     * and/or cmp function that considers information that changes during the
+     * life of the object.
+     */
+    {
+        ici_obj_t   **a;
+
+        if ((a = &atoms[atomsz]) != NULL)
+        {
+            while (--a >= atoms)
+            {
+                if (*a == NULL || ici_atom_dead(*a))
+                    continue;
+                assert((*a)->o_flags & O_ATOM);
+                assert(atom_hashes[a - atoms] == hash(*a));
+                assert(atom_probe(*a, NULL) == *a);
+            }
+        }
+    }
+#   endif
+
+    major = 1;
+    if (gc_phase == GC_IDLE)
+    {
+        major = ici_gc_nongenerational || gc_need_major || ici_mem_used >= gc_old_limit;
+        if (major && ici_gc_pause > 0 && !ici_gc_nongenerational && !gc_reclaiming)
+            gc_begin();
+        else
+            gc_all_at_once(major);
+    }
+    if (gc_phase != GC_IDLE)
+    {
+        gc_step(gc_reclaiming || ici_mem_used > 2 * gc_old_limit);
+        if (gc_phase != GC_IDLE)
+        {
+#           if ALLCOLLECT
+                ici_mem_limit = 0;
+#           else
+                ici_mem_limit = ici_mem_used + GC_STEP;
+#           endif
+            gc_account(start, cpu);
+            --ici_supress_collect;
+            return;
+        }
+    }
+
+    /*
+     * Set ici_mem_limit (which is the point at which to trigger a new call
+     * to us) to allow for another nursery's worth of allocation.  After a
+     * major collection, also set the point at which we will do the next
+     * major one (see gc_set_old_limit()).  When every collection is a
+     * major one there is no nursery, and the next collection waits until
+     * the heap has grown in proportion to what was left, as it did in older
+     * versions of ICI.
+     */
+    if (ici_mem_used < 0)
+        ici_mem_used = 0;
+    if (major)
+    {
+        ++gc_majors;
+        gc_set_old_limit();
+        ici_trim_alloc();
+    }
+    else
+        ++gc_minors;
+#   if ALLCOLLECT
+        ici_mem_limit = 0;
+#   else
+        if (ici_gc_nongenerational)
+            ici_mem_limit = gc_old_limit;
+        else if (ici_mem_used / 8 > GC_NURSERY)
+            ici_mem_limit = ici_mem_used + ici_mem_used / 8;
+        else
+            ici_mem_limit = ici_mem_used + GC_NURSERY;
+        if (ici_mem_limit > gc_old_limit)
+            ici_mem_limit = gc_old_limit;
+        if (ici_gc_ceiling > 0 && ici_mem_used < ici_gc_ceiling && ici_mem_limit > ici_gc_ceiling)
+            ici_mem_limit = ici_gc_ceiling;
+#   endif
+    gc_account(start, cpu);
+    --ici_supress_collect;
+}
+
+#ifndef NDEBUG
+void
+ici_dump_refs(void)
+{
+    ici_obj_t           **a;
+    char                n[30];
+
+    if (objs_top > objs + 3)
+    {
+        printf("The following registered objects have not been freed...\n");
+        for (a = objs; a < objs_top; ++a)
+            if (*a != objof(&ici_xs) && *a != objof(&ici_os) && *a != objof(&ici_vs))
+                printf("%d 0x%08lX: %s\n", (*a)->o_nrefs, (unsigned long)*a, ici_objname(n, *a));
+    }
+}
+#endif
+
+/*
+ * Garbage collection triggered by other than our internal mechanmism.
+ * Don't do this unless you really must. It will free all memory it can
+ * but will reduce subsequent performance.
+ */
+void
+ici_reclaim(void)
+{
+    gc_reclaiming = 1;
+    if (gc_phase != GC_IDLE)
+        collect();
+    gc_need_major = 1;
+    collect();
+    gc_reclaiming = 0;
+}
+
+/*
+ * Count the objects in objs[] from 'a' to 'e', and their sizes, into the
+ * given arrays indexed by type code.  They must all be marked, as they are
+ * once a collection is done, so that the mark function of each, called
+ * with its mark cleared, finds everything it references already marked and
+ * returns its own size alone.
+ */
+static void
+gc_census(ici_obj_t **a, ici_obj_t **e, long *nobjs, long *bytes)
+{
+    register ici_obj_t  *o;
+
+    for (; a < e; ++a)
+    {
+        o = *a;
+        ++nobjs[(int)o->o_tcode];
+        if (o->o_leafz != 0)
+            bytes[(int)o->o_tcode] += o->o_leafz;
+        else if (o->o_flags & O_MARK)
+        {
+            o->o_flags &= ~O_MARK;
+            bytes[(int)o->o_tcode] += (*ici_typeof(o)->t_mark)(o);
+        }
+    }
+}
+
+/*
+ * Freeze everything now in the heap.  A full collection is done, then
+ * what survives is put in a generation of its own that later collections
+ * never clear, mark or sweep, and so never write to.  This is for programs
+ * that load a lot and then fork() worker processes, which can then go on
+ * sharing that memory copy-on-write.  Frozen objects are never freed, even
+ * if they become garbage.  One that is changed (through the write barrier,
+ * see ici_wb()) is thawed, and from then on every collection looks in it.
+ * Objects that are held by C code, or of types not subject to the write
+ * barrier, are thawed from the start.  If there is no memory to record what
+ * is frozen, nothing more is.  See also ici_gc_thaw().
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_gc_freeze(void)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  *o;
+    ici_obj_t           **e;
+    ici_obj_t           **old;
+    size_t              oldz;
+    size_t              z;
+
+    ici_reclaim();
+    if (gc_phase != GC_IDLE)
+        return;
+    /*
+     * Grow gc_frozen_set to keep it no more than half full, moving the
+     * entries of those already frozen across.  Collection is held off so
+     * that what is to be frozen stays put while we allocate.
+     */
+    for (z = 256; z < 2 * (size_t)objs_nold; z <<= 1)
+        ;
+    if (z > gc_frozen_setz)
+    {
+        old = gc_frozen_set;
+        oldz = gc_frozen_setz;
+        ++ici_supress_collect;
+        gc_frozen_set = (ici_obj_t **)ici_nalloc(z * sizeof(ici_obj_t *));
+        --ici_supress_collect;
+        if (gc_frozen_set == NULL)
+        {
+            gc_frozen_set = old;
+            return;
+        }
+        memset((char *)gc_frozen_set, 0, z * sizeof(ici_obj_t *));
+        gc_frozen_setz = z;
+        if (old != NULL)
+        {
+            for (e = old; e < old + oldz; ++e)
+            {
+                if (*e != NULL)
+                    *gc_frozen_slot(gc_frozen_obj(*e)) = *e;
+            }
+            ici_nfree(old, oldz * sizeof(ici_obj_t *));
+        }
+    }
+    gc_census(objs + objs_nfrozen, objs + objs_nold, gc_frozen_objs, gc_frozen_bytes);
+    for (a = objs + objs_nfrozen; a < objs + objs_nold; ++a)
+    {
+        o = *a;
+        e = gc_frozen_slot(o);
+        *e = o;
+        /*
+         * Functions only change (their kept autos) through the write
+         * barrier.
+         */
+        if (o->o_nrefs != 0 || (gc_rescan(o) && o->o_tcode != TC_FUNC))
+        {
+            *e = (ici_obj_t *)((unsigned long)o | GC_THAWED);
+            gc_thawing = 1;
+        }
+    }
+    objs_nfrozen = objs_nold;
+    gc_held.l_top = gc_held.l_base;
+    gc_rescans.l_top = gc_rescans.l_base;
+}
+
+/*
+ * Return the frozen generation (see ici_gc_freeze()) to the rest of the
+ * heap, so that what is garbage in it can be freed by the next collection,
+ * which will be a major one.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_gc_thaw(void)
+{
+    register ici_obj_t  **a;
+    register ici_obj_t  *o;
+
+    if (gc_phase != GC_IDLE)
+    {
+        gc_reclaiming = 1;
+        collect();
+        gc_reclaiming = 0;
+        if (gc_phase != GC_IDLE)
+            return;
+    }
+    /*
+     * They become ordinary old objects, so go on the lists a sweep would
+     * have put them on.
+     */
+    for (a = objs; a < objs + objs_nfrozen; ++a)
+    {
+        o = *a;
+        if (gc_rescan(o))
+            gc_list_add(&gc_rescans, o);
+        else if (o->o_nrefs != 0 && gc_container(o) && (o->o_flags & O_ATOM) == 0)
+            gc_list_add(&gc_held, o);
+    }
+    objs_nfrozen = 0;
+    if (gc_frozen_set != NULL)
+    {
+        ici_nfree(gc_frozen_set, gc_frozen_setz * sizeof(ici_obj_t *));
+        gc_frozen_set = NULL;
+        gc_frozen_setz = 0;
+    }
+    gc_thawed.l_top = gc_thawed.l_base;
+    gc_thawing = 0;
+    gc_need_major = 1;
+    memset(gc_frozen_objs, 0, sizeof gc_frozen_objs);
+    memset(gc_frozen_bytes, 0, sizeof gc_frozen_bytes);
+}
+
+/*
+ * Fill in '*gs' with statistics of the garbage collector and the allocator
+ * (see struct ici_gcstats).  A collection is done first, so that what is
+ * counted by type is what survived it, and how much of the heap each type
+ * takes is then found by going through it all, which takes time in
+ * proportion to its size.  The frozen generation (see ici_gc_freeze()) is
+ * counted as it was when it was frozen.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_gc_stats(ici_gcstats_t *gs)
+{
+    int                 i;
+
+    memset(gs, 0, sizeof *gs);
+    if (!ici_supress_collect)
+    {
+        collect();
+        if (gc_phase != GC_IDLE)
+        {
+            gc_reclaiming = 1;
+            collect();
+            gc_reclaiming = 0;
+        }
+    }
+    for (i = 0; i < ICI_MAX_TYPES; ++i)
+    {
+        gs->gs_type_objects[i] = gc_frozen_objs[i];
+        gs->gs_type_bytes[i] = gc_frozen_bytes[i];
+    }
+    if (gc_phase == GC_IDLE)
+    {
+        gc_census(objs + objs_nfrozen, objs + objs_nold, gs->gs_type_objects, gs->gs_type_bytes);
+        gc_census(objs + objs_nold, objs_top, gs->gs_type_objects, gs->gs_type_bytes);
+    }
+    gs->gs_minors = gc_minors;
+    gs->gs_majors = gc_majors;
+    gs->gs_pause_total = gc_pause_total;
+    gs->gs_pause_max = gc_pause_max;
+    gs->gs_mem_used = ici_mem_used;
+    gs->gs_mem_limit = ici_mem_limit;
+    gs->gs_objects = objs_top - objs;
+    gs->gs_frozen = objs_nfrozen;
+    gs->gs_natoms = ici_natoms;
+    gs->gs_atomsz = atomsz;
+    ici_alloc_stats(gs);
+}
+
+
+/*
+ * Output for ici_heap_dump(), buffered.
+ */
+typedef struct
+{
+    ici_file_t          *d_file;
+    int                 d_n;
+    int                 d_failed;
+    char                d_buf[4096];
+}
+gcdump_t;
+
+static void
+gc_dump_flush(gcdump_t *d)
+{
+    if
+    (
+        d->d_n != 0
+        &&
+        (*d->d_file->f_type->ft_write)(d->d_buf, d->d_n, d->d_file->f_file) != d->d_n
+    )
+        d->d_failed = 1;
+    d->d_n = 0;
+}
+
+static void
+gc_dump_bytes(gcdump_t *d, char *p, size_t n)
+{
+    size_t              m;
+
+    while (n != 0)
+    {
+        if (d->d_n == sizeof d->d_buf)
+            gc_dump_flush(d);
+        m = sizeof d->d_buf - d->d_n;
+        if (m > n)
+            m = n;
+        memcpy(d->d_buf + d->d_n, p, m);
+        d->d_n += m;
+        p += m;
+        n -= m;
+    }
+}
+
+/*
+ * Numbers are written seven bits to a byte, least significant first, with
+ * the top bit set on all but the last.
+ */
+static void
+gc_dump_num(gcdump_t *d, unsigned long v)
+{
+    char                b[(sizeof v * 8 + 6) / 7];
+    int                 n;
+
+    n = 0;
+    do
+    {
+        b[n] = v & 0x7F;
+        if ((v >>= 7) != 0)
+            b[n] |= 0x80;
+        ++n;
+    } while (v != 0);
+    gc_dump_bytes(d, b, n);
+}
+
+static void
+gc_dump_str(gcdump_t *d, char *p, size_t n)
+{
+    gc_dump_num(d, n);
+    gc_dump_bytes(d, p, n);
+}
+
+static int
+gc_ptr_cmp(const void *a, const void *b)
+{
+    return *(ici_obj_t **)a < *(ici_obj_t **)b ? -1 : *(ici_obj_t **)a > *(ici_obj_t **)b;
+}
+
+/*
+ * The number by which object 'o' is known in a heap dump: one more than
+ * its place in the sorted copy of objs[], 'sorted', or zero if it isn't
+ * in the heap.
+ */
+static unsigned long
+gc_dump_id(ici_obj_t *o, ici_obj_t **sorted, ptrdiff_t n)
+{
+    ici_obj_t           **a;
+
+    if (o == NULL)
+        return 0;
+    a = (ici_obj_t **)bsearch(&o, sorted, n, sizeof *sorted, gc_ptr_cmp);
+    return a == NULL ? 0 : a - sorted + 1;
+}
+
+/*
+ * Write a description of the object 'o' to a heap dump, for the reader to
+ * know it by.  Strings give their text, functions their name and where
+ * they were defined, source markers their place, and the objects of types
+ * defined by extensions their usual name.
+ */
+static void
+gc_dump_label(gcdump_t *d, ici_obj_t *o)
+{
+    char                n[ICI_OBJNAMEZ + 300];
+    ici_src_t           *s;
+    int                 line;
+
+    switch (o->o_tcode)
+    {
+    case TC_STRING:
+        gc_dump_str(d, stringof(o)->s_chars, stringof(o)->s_nchars < 64 ? stringof(o)->s_nchars : 64);
+        return;
+
+    case TC_FUNC:
+        s = NULL;
+        if (funcof(o)->f_code != NULL)
+            s = ici_src_find(funcof(o)->f_code, 0, &line);
+        if (s != NULL && s->s_filename != NULL)
+        {
+            sprintf(n, "%.64s() %.200s:%d", funcof(o)->f_name->s_chars,
+                s->s_filename->s_chars, line);
+            break;
+        }
+        sprintf(n, "%.64s()", funcof(o)->f_name->s_chars);
+        break;
+
+    case TC_SRC:
+        if (srcof(o)->s_filename == NULL)
+        {
+            gc_dump_str(d, "", 0);
+            return;
+        }
+        sprintf(n, "%.200s:%d", srcof(o)->s_filename->s_chars, srcof(o)->s_lineno);
+        break;
+
+    default:
+        if (o->o_tcode <= TC_MAX_CORE)
+        {
+            gc_dump_str(d, "", 0);
+            return;
+        }
+        ici_objname(n, o);
+        break;
+    }
+    gc_dump_str(d, n, strlen(n));
+}
+
+/*
+ * Write a snapshot of the heap to the file 'f' in the binary form read by
+ * heap-report.ici.  A full collection is done first, so just what is
+ * reachable is written.  Returns non-zero on error, usual conventions.
+ *
+ * All numbers are written as described at gc_dump_num() above, and strings
+ * as their length followed by their bytes.  The file starts with the eight
+ * bytes "ICIHEAP1", then the number of types, and for each its code and
+ * name.  Then comes the number of objects, and for each:
+ *
+ *  - its type code;
+ *  - flags: 1 if held by C code or the interpreter (a root of the
+ *    collector), 2 if an atom, 4 if frozen (see ici_gc_freeze());
+ *  - its own size, as given by its mark function or o_leafz;
+ *  - a label (see gc_dump_label());
+ *  - the number of its super, or 0;
+ *  - the number of objects it references, then their numbers.
+ *
+ * Objects are numbered from 1 in the order they are written, and 0 stands
+ * for one that isn't in the heap.  The references of a struct are the key
+ * and value of each slot in turn.  Those of other types are found by
+ * running their mark functions with all marks cleared, and ici_mark_defer()
+ * noting the objects they reach rather than marking them.  So this works
+ * for the types of extensions too.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+int
+ici_heap_dump(ici_file_t *f)
+{
+    gcdump_t            *d;
+    ici_obj_t           **sorted;
+    char                *leafz;
+    char                *marked;
+    ptrdiff_t           n;
+    ptrdiff_t           i;
+    ici_obj_t           *o;
+    ici_obj_t           *super;
+    ici_obj_t           **r;
+    ici_sslot_t         *sl;
+    unsigned long       size;
+    int                 flags;
+    int                 supmark;
+
+    if (ici_supress_collect)
+    {
+        ici_error = "heap dump attempted during collection";
+        return 1;
+    }
+    ici_reclaim();
+    if (gc_phase != GC_IDLE)
+    {
+        ici_error = "unable to finish collection for heap dump";
+        return 1;
+    }
+    n = objs_top - objs;
+    d = (gcdump_t *)malloc(sizeof(gcdump_t));
+    sorted = (ici_obj_t **)malloc(n * sizeof(ici_obj_t *) + 1);
+    leafz = (char *)malloc(n + 1);
+    marked = (char *)malloc(n + 1);
+    if (d == NULL || sorted == NULL || leafz == NULL || marked == NULL)
+    {
+        free(d);
+        free(sorted);
+        free(leafz);
+        free(marked);
+        ici_error = "ran out of memory";
+        return 1;
+    }
+    d->d_file = f;
+    d->d_n = 0;
+    d->d_failed = 0;
+    memcpy(sorted, objs, n * sizeof(ici_obj_t *));
+    qsort(sorted, n, sizeof(ici_obj_t *), gc_ptr_cmp);
+
+    /*
+     * Clear the marks (which say what is old), and the o_leafz that would
+     * let ici_mark() mark leaves itself, so every object reached goes to
+     * ici_mark_defer().  Both are put back after.
+     */
+    ++ici_supress_collect;
+    for (i = 0; i < n; ++i)
+    {
+        leafz[i] = sorted[i]->o_leafz;
+        marked[i] = (sorted[i]->o_flags & O_MARK) != 0;
+        sorted[i]->o_leafz = 0;
+        sorted[i]->o_flags &= ~O_MARK;
+    }
+    gc_dumping = 1;
+    gc_dump_failed = 0;
+    ici_gc_defer = 1;
+
+    gc_dump_bytes(d, "ICIHEAP1", 8);
+    for (i = 0, flags = 0; i < ICI_MAX_TYPES; ++i)
+        flags += ici_types[i] != NULL;
+    gc_dump_num(d, flags);
+    for (i = 0; i < ICI_MAX_TYPES; ++i)
+    {
+        if (ici_types[i] != NULL)
+        {
+            gc_dump_num(d, i);
+            gc_dump_str(d, ici_types[i]->t_name, strlen(ici_types[i]->t_name));
+        }
+    }
+    gc_dump_num(d, n);
+    for (i = 0; i < n; ++i)
+    {
+        o = sorted[i];
+        /*
+         * A struct's mark function goes straight on to an unmarked super,
+         * so it is marked for the while.  The super is written separately.
+         */
+        super = NULL;
+        supmark = 0;
+        if ((o->o_flags & O_SUPER) != 0 && (super = objof(objwsupof(o)->o_super)) != NULL)
+        {
+            supmark = super->o_flags & O_MARK;
+            super->o_flags |= O_MARK;
+        }
+        gc_dump_refs.l_top = gc_dump_refs.l_base;
+        if (leafz[i] != 0)
+            size = (unsigned char)leafz[i];
+        else
+            size = (*ici_typeof(o)->t_mark)(o);
+        o->o_flags &= ~O_MARK;
+        if (super != NULL && !supmark)
+            super->o_flags &= ~O_MARK;
+
+        flags = 0;
+        if (o->o_nrefs != 0)
+            flags |= 1;
+        if (o->o_flags & O_ATOM)
+            flags |= 2;
+        if (objs_nfrozen != 0 && gc_is_frozen(o))
+            flags |= 4;
+        gc_dump_num(d, o->o_tcode);
+        gc_dump_num(d, flags);
+        gc_dump_num(d, size);
+        gc_dump_label(d, o);
+        gc_dump_num(d, gc_dump_id(super, sorted, n));
+        if (o->o_tcode == TC_STRUCT)
+        {
+            gc_dump_num(d, 2 * structof(o)->s_nels);
+            for (sl = structof(o)->s_slots; sl < structof(o)->s_slots + structof(o)->s_nslots; ++sl)
+            {
+                if (sl->sl_key != NULL)
+                {
+                    gc_dump_num(d, gc_dump_id(sl->sl_key, sorted, n));
+                    gc_dump_num(d, gc_dump_id(sl->sl_value, sorted, n));
+                }
+            }
+        }
+        else
+        {
+            gc_dump_num(d, gc_dump_refs.l_top - gc_dump_refs.l_base);
+            for (r = gc_dump_refs.l_base; r < gc_dump_refs.l_top; ++r)
+                gc_dump_num(d, gc_dump_id(*r, sorted, n));
+        }
+    }
+    gc_dump_flush(d);
+
+    gc_dumping = 0;
+    ici_gc_defer = 0;
+    gc_list_free(&gc_dump_refs);
+    for (i = 0; i < n; ++i)
+    {
+        sorted[i]->o_leafz = leafz[i];
+        if (marked[i])
+            sorted[i]->o_flags |= O_MARK;
+    }
+    --ici_supress_collect;
+    free(leafz);
+    free(marked);
+    free(sorted);
+    if (d->d_failed || gc_dump_failed)
+    {
+        ici_error = d->d_failed ? "write failed" : "ran out of memory";
+        free(d);
+        return 1;
+    }
+    free(d);
+    return 0;
+}
+
+
+#ifdef  BUGHUNT
+
+ici_obj_t   *traceobj;
+
+void
 bughunt_incref(ici_obj_t *o)
 {
     if (o == traceobj)
@@ -883,10 +2967,11 @@ ici_init_object(void)
     objs_limit = NULL;
     objs_top = NULL;
 
-    if ((atoms = (ici_obj_t **)ici_nalloc(64 * sizeof(ici_obj_t *))) == NULL)
+    if ((atoms = (ici_obj_t **)ici_nalloc(ICI_ATOMS_SIZE(64))) == NULL)
         return 1;
     atomsz = 64; /* Must be power of two. */
     memset((char *)atoms, 0, atomsz * sizeof(ici_obj_t *));
+    atom_hashes = (unsigned long *)(atoms + atomsz);
     
     if ((objs = (ici_obj_t **)ici_nalloc(256 * sizeof(ici_obj_t *))) == NULL)
         return 1;
@@ -906,11 +2991,31 @@ ici_uninit_object(void)
 {
     assert(ici_supress_collect == 0);
 
-    ici_nfree(atoms, atomsz * sizeof(ici_obj_t *));
+    ici_nfree(atoms, ICI_ATOMS_SIZE(atomsz));
     atoms = NULL;
+    atom_hashes = NULL;
     atomsz = 0;
     ici_natoms = 0;
     
+    gc_list_free(&gc_held);
+    gc_list_free(&gc_rescans);
+    gc_list_free(&gc_grey);
+    gc_list_free(&gc_thawed);
+    gc_thawing = 0;
+    objs_nfrozen = 0;
+    if (gc_frozen_set != NULL)
+        ici_nfree(gc_frozen_set, gc_frozen_setz * sizeof(ici_obj_t *));
+    gc_frozen_set = NULL;
+    gc_frozen_setz = 0;
+#ifdef GC_PARALLEL
+    gc_par_uninit();
+#endif
+    gc_nremembered = 0;
+    gc_phase = GC_IDLE;
+    ici_gc_marking = 0;
+    ici_gc_sweeping = 0;
+    objs_nold = 0;
+
     ici_nfree(objs, (objs_limit - objs) * sizeof(ici_obj_t *));
     objs = NULL;
     objs_limit = NULL;
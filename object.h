@@ -232,12 +232,28 @@ struct ici_type
  * Thus the size of this macro. The o_leafz field of an object tells us it
  * doesn't reference any other objects and is of small (ie o_leafz) size.
  *
+ * During a step of an incremental collection (when ici_gc_defer is set)
+ * objects that reference others are not recursed into here, but marked and
+ * left for the collector to scan later. See ici_mark_defer() in object.c.
+ *
+ * When marking is shared between threads (see gc_par_run() in object.c),
+ * two of them may mark the same leaf here at once with a plain |=.  That
+ * is safe.  While they run nothing else changes o_flags, and all of them
+ * only ever set O_MARK in it, so whichever store lands last leaves O_MARK
+ * set and the other flags as they were.  o_flags is a char of its own, so
+ * the store doesn't touch the fields beside it.  A leaf is never looked
+ * in, so marking it twice does no harm (the sizes returned are not used in
+ * a parallel run).  Objects that reference others are claimed atomically
+ * instead, as each must be looked in by only one thread.
+ *
  * Note that the argument 'o' is subject to multiple expansions.
  */
 #define ici_mark(o)         ((objof(o)->o_flags & O_MARK) == 0 \
                             ? (objof(o)->o_leafz != 0 \
                                 ? (objof(o)->o_flags |= O_MARK, objof(o)->o_leafz) \
-                                : (*ici_typeof(o)->t_mark)(objof(o))) \
+                                : ici_gc_defer \
+                                    ? ici_mark_defer(objof(o)) \
+                                    : (*ici_typeof(o)->t_mark)(objof(o))) \
                             : 0L)
 
 /*
@@ -345,9 +361,13 @@ struct ici_type
  * caller is expected to ici_decref() it when they attach it into wherever it
  * is going.
  *
+ * While an incremental collection is marking, a newly held object is also
+ * noted so that it will be marked (see ici_gc_shade() in object.c).
+ *
  * This --macro-- forms part of the --ici-api--.
  */
-#define ici_incref(o)       (++objof(o)->o_nrefs)
+#define ici_incref(o)       (ici_gc_marking ? ici_gc_shade(objof(o)) : (void)0, \
+                            ++objof(o)->o_nrefs)
 
 /*
  * Decrement the object 'o's reference count.  References from ordinary
@@ -518,6 +538,25 @@ struct ici_objwsup
  */
 #define ici_rego(o)     ici_rego_work(objof(o))
 
+/*
+ * The write barrier.  The garbage collector is generational, and a minor
+ * collection does not look inside objects that have survived an earlier
+ * collection unless it has been told they have changed.  So code that
+ * stores a reference to an object into an existing array, struct or set by
+ * any means other than ici_assign() (for example, by pushing directly onto
+ * 'a_top' of an array it did not just make) must apply this to the array,
+ * struct or set first.  It is cheap, and does nothing to new objects.
+ *
+ * Objects of types registered with ici_register_type() are re-scanned by
+ * every collection, so extensions need not use this on their own types.
+ *
+ * Note that the argument 'o' is subject to multiple expansions.
+ *
+ * This --macro-- forms part of the --ici-api--.
+ */
+#define ici_wb(o)       ((objof(o)->o_flags & O_MARK) != 0 \
+                            ? ici_remember(objof(o)) : (void)0)
+
 /*
  * The o_tcode field is a small int. These are the "well known" core
  * language types. See comments on o_tcode above and ici_types above.
@@ -551,13 +590,44 @@ struct ici_objwsup
 #define TC_MEM          23
 #define TC_PROFILECALL  24
 #define TC_CODE         25
+#define TC_ICACHE       26
 
-#define TC_MAX_CORE     25
+#define TC_MAX_CORE     26
 
 #define TRI(a,b,t)      (((((a) << 4) + b) << 6) + t_subtype(t))
 
 #define isfalse(o)      ((o) == objof(ici_zero) || (o) == objof(&o_null))
 
+/*
+ * Statistics of the garbage collector and the allocator, as filled in by
+ * ici_gc_stats().  Times are in seconds and sizes in bytes, in the terms
+ * of ici_mem_used.  The counts by type are indexed by type code (see
+ * ici_types[]).
+ *
+ * This --struct-- forms part of the --ici-api--.
+ */
+struct ici_gcstats
+{
+    long        gs_minors;      /* Minor collections done. */
+    long        gs_majors;      /* Major collections finished. */
+    double      gs_pause_total; /* Time spent collecting. */
+    double      gs_pause_max;   /* The longest single pause. */
+    long        gs_mem_used;    /* ici_mem_used. */
+    long        gs_mem_limit;   /* ici_mem_limit. */
+    long        gs_objects;     /* Objects in the heap. */
+    long        gs_frozen;      /* Of those, frozen (ici_gc_freeze()). */
+    long        gs_type_objects[ICI_MAX_TYPES];
+    long        gs_type_bytes[ICI_MAX_TYPES];
+    long        gs_natoms;      /* Objects in the atom pool. */
+    long        gs_atomsz;      /* Slots in the atom pool. */
+    long        gs_n_allocs;    /* Blocks from ici_alloc(). */
+    long        gs_alloc_mem;   /* And their estimated size. */
+    long        gs_flist_size[ICI_NFLISTS]; /* Block size of each... */
+    long        gs_flist_free[ICI_NFLISTS]; /* ...and blocks on it. */
+    long        gs_runs;        /* Runs free list blocks are cut from. */
+    long        gs_idle_runs;   /* Of those, empty ones given back. */
+};
+
 /*
  * End of ici.h export. --ici.h-end--
  */
@@ -584,11 +654,51 @@ extern void             bughunt_rego(ici_obj_t *);
 
 #define ICI_STORE_ATOM_AND_COUNT(po, s) \
         ((*(po) = objof(s)), \
+        (ici_gc_sweeping ? objof(s)->o_flags |= O_MARK : 0), \
         ((++ici_natoms > atomsz / 2) ? \
             ici_grow_atoms(atomsz * 2), 0 : 0))
 
+/*
+ * While an incremental collection is sweeping, the atom pool may still hold
+ * objects that have been found to be garbage but are yet to be freed.  These
+ * are the unmarked ones (atoms made during the sweep are marked as they go
+ * in, see above).  Lookups in the atom pool must pass over them.
+ */
+#define ici_atom_dead(o) (ici_gc_sweeping && ((o)->o_flags & O_MARK) == 0)
+
 #define ici_atom_hash_index(h)  ((h) & (atomsz - 1))
 
+/*
+ * Floats made by arithmetic (see binop.h) and long strings made by things
+ * like + and getfile() (see ici_str_lazy()) are not made atoms when they are
+ * made.  They are just as immutable though, and as far as the program can
+ * tell they are atoms.  This is true of such an object.  Operand stack temps
+ * are left out.  They never get far enough to matter.
+ */
+#define ici_is_lazy_atom(o) \
+    (((o)->o_flags & (O_ATOM | O_TEMP)) == 0 \
+        && ((o)->o_tcode == TC_FLOAT \
+            || ((o)->o_tcode == TC_STRING \
+                && ((o)->o_flags & (ICI_S_SEP_ALLOC | ICI_S_READONLY)) != ICI_S_SEP_ALLOC)))
+
+/*
+ * Struct and set keys are found by identity.  So anything about to be used
+ * as a key is passed through this, which gives the atomic form of a lazy
+ * atom (it is only made an atom when it is first used this way).  Needs
+ * str.h.
+ */
+#define ici_keyof(k) \
+    (ici_is_lazy_atom(k) ? ici_atom((k), 0) : (k))
+
+/*
+ * The atom pool is one allocation, holding the atoms[] hash table then
+ * atom_hashes[], the hash of the atom in each slot.  Anything that stores
+ * into atoms[] must store the hash too (atom_probe() does this for the
+ * slot it returns).  Probes compare it before calling the type's cmp
+ * function, and growing or deleting from the pool need not hash again.
+ */
+#define ICI_ATOMS_SIZE(n)       ((n) * (sizeof(ici_obj_t *) + sizeof(unsigned long)))
+
 #ifdef BUGHUNT
 #   undef ici_incref
 #   undef ici_decref
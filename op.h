@@ -67,6 +67,9 @@ enum
     OP_ANDAND,
     OP_SWITCH,
     OP_SWITCHER,
+    OP_QUICKBINOP,
+    OP_ICDOT,
+    OP_ICMETHOD_CALL,
 };
 
 /*
@@ -75,6 +78,7 @@ enum
  * implemented.
  */
 extern ici_op_t         o_quote;
+extern ici_op_t         o_quickbinop;
 extern ici_op_t         o_looper;
 extern ici_op_t         o_loop;
 extern ici_op_t         o_rewind;
@@ -87,6 +91,7 @@ extern ici_op_t         o_mkfunc;
 extern ici_op_t         o_return;
 extern ici_op_t         o_call;
 extern ici_op_t         o_method_call;
+extern ici_op_t         o_icmethod_call;
 extern ici_op_t         o_super_call;
 extern ici_op_t         o_if;
 extern ici_op_t         o_ifnot;
@@ -97,6 +102,7 @@ extern ici_op_t         o_pop;
 extern ici_op_t         o_colon;
 extern ici_op_t         o_coloncaret;
 extern ici_op_t         o_dot;
+extern ici_op_t         o_icdot;
 extern ici_op_t         o_dotkeep;
 extern ici_op_t         o_dotrkeep;
 extern ici_op_t         o_mkptr;
@@ -68,6 +68,9 @@ opname(ici_op_t *op)
     case OP_ANDAND: return "OP_ANDAND";
     case OP_SWITCH: return "OP_SWITCH";
     case OP_SWITCHER: return "OP_SWITCHER";
+    case OP_QUICKBINOP: return "OP_QUICKBINOP";
+    case OP_ICDOT: return "OP_ICDOT";
+    case OP_ICMETHOD_CALL: return "OP_ICMETHOD_CALL";
     default: return "op by function";
     }
 }
@@ -94,6 +97,36 @@ disassemble(int indent, ici_array_t *a)
 }
 #endif
 
+/*
+ * Finish the code array 'a', now that nothing more will be added to it.
+ * Its source markers, apart from any in its first 'keep' elements, are
+ * moved out of the code to a line table (see ici_src_table()), unless the
+ * debugger is on and wants to see them as they are reached.  Then its
+ * memory is cut down to just what it uses.
+ *
+ * Returns non-zero on error, usual conventions.
+ */
+static int
+finish_code(ici_array_t *a, ptrdiff_t keep)
+{
+    ici_obj_t           **e;
+    ptrdiff_t           n;
+
+    if (!ici_debug_active && ici_src_table(a, keep))
+        return 1;
+    if ((n = a->a_top - a->a_base) == 0 || n == a->a_limit - a->a_base)
+        return 0;
+    if ((e = (ici_obj_t **)ici_nalloc(n * sizeof(ici_obj_t *))) == NULL)
+        return 1;
+    memcpy((char *)e, (char *)a->a_base, n * sizeof(ici_obj_t *));
+    ici_nfree((char *)a->a_base, (a->a_limit - a->a_base) * sizeof(ici_obj_t *));
+    a->a_base = e;
+    a->a_bot = e;
+    a->a_top = e + n;
+    a->a_limit = e + n;
+    return 0;
+}
+
 /*
  * In general, parseing functions return -1 on error (and set the global
  * error string), 0 if they encountered an early head symbol conflict (and
@@ -284,6 +317,8 @@ function(ici_parse_t *p, ici_str_t *name)
     *f->f_code->a_top++ = objof(&o_null);
     *f->f_code->a_top++ = objof(&o_return);
     *f->f_code->a_top++ = objof(&o_end);
+    if (finish_code(f->f_code, 0))
+        goto fail;
 #   if DISASSEMBLE
         printf("%s()\n", name == NULL ? "?" : name->s_chars);
         disassemble(4, f->f_code);
@@ -1408,6 +1443,42 @@ fail:
     return -1;
 }
 
+/*
+ * The code for the expression of a "return expr;" has just been put on the
+ * end of 'a'.  If it ends with a call, flag that call as being in tail
+ * position (see ici_tail_call_frame()).  Returns non-zero on error, usual
+ * conventions.
+ */
+static int
+tail_call(ici_array_t *a)
+{
+    ici_obj_t           **e;
+    ici_op_t            *op;
+
+    e = a->a_top - 1;
+    if (e > a->a_bot && isicache(*e))
+        --e; /* The inline cache after an o_icmethod_call. */
+    if (e < a->a_bot || !isop(*e) || opof(*e)->op_code != 0)
+        return 0;
+    switch (opof(*e)->op_ecode)
+    {
+    case OP_CALL:
+    case OP_METHOD_CALL:
+    case OP_ICMETHOD_CALL:
+    case OP_SUPER_CALL:
+        break;
+
+    default:
+        return 0;
+    }
+    if ((op = new_op(NULL, opof(*e)->op_ecode, OPC_TAIL_CALL)) == NULL)
+        return 1;
+    ici_wb(a);
+    *e = objof(op);
+    ici_decref(op);
+    return 0;
+}
+
 /*
  * a    Code array being appended to.
  * sw   Switch structure, else NULL.
@@ -1621,6 +1692,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
             }
             if (a2 != NULL)
             {
+                ici_wb(a);
                 *a->a_top++ = objof(&o_ifelse);
                 *a->a_top++ = objof(a1);
                 *a->a_top++ = objof(a2);
@@ -1629,6 +1701,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
             else
             {
                 *a->a_top++ = objof(&o_if);
+                ici_wb(a);
                 *a->a_top++ = objof(a1);
             }
             ici_decref(a1);
@@ -1667,12 +1740,13 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 return -1;
             }
             *a1->a_top++ = objof(&o_rewind);
-            if (ici_stk_push_chk(a, 2))
+            if (finish_code(a1, 0) || ici_stk_push_chk(a, 2))
             {
                 ici_decref(a1);
                 return -1;
             }
             *a->a_top++ = objof(&o_loop);
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             break;
@@ -1726,12 +1800,13 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
             *a1->a_top++ = objof(&o_ifnotbreak);
             *a1->a_top++ = objof(&o_rewind);
 
-            if (ici_stk_push_chk(a, 2))
+            if (finish_code(a1, 0) || ici_stk_push_chk(a, 2))
             {
                 ici_decref(a1);
                 return -1;
             }
             *a->a_top++ = objof(&o_loop);
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             break;
@@ -1806,11 +1881,13 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 ici_decref(a1);
                 return -1;
             }
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             if ((*a->a_top = objof(new_op(ici_op_forall, 0, 0))) == NULL)
                 return -1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             ++a->a_top;
             break;
 
@@ -1903,16 +1980,18 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 return -1;
             }
             *a1->a_top++ = objof(&o_rewind);
-            if (ici_stk_push_chk(a, 2))
+            if (finish_code(a1, stepz) || ici_stk_push_chk(a, 2))
             {
                 ici_decref(a1);
                 return -1;
             }
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             if ((*a->a_top = objof(new_op(ici_op_for, 0, stepz))) == NULL)
                 return -1;
             ici_decref(*a->a_top);
+            ici_wb(a);
             ++a->a_top;
             break;
         }
@@ -1943,6 +2022,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 ici_decref(p->p_got.t_obj);
                 return -1;
             }
+            ici_wb(a);
             *a->a_top++ = p->p_got.t_obj;
             ici_decref(p->p_got.t_obj);
             *a->a_top++ = objof(d);
@@ -1997,6 +2077,11 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 if ((*a->a_top = objof(&o_null)) == NULL)
                     return -1;
                 ++a->a_top;
+                break;
+
+            default:
+                if (!ici_dont_optimize && tail_call(a))
+                    return -1;
             }
             if (next(p, a) != T_SEMICOLON)
             {
@@ -2040,6 +2125,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 ici_decref(a2);
                 return -1;
             }
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             *a->a_top++ = objof(a2);
             *a->a_top++ = objof(&o_onerror);
@@ -2058,6 +2144,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 return -1;
             if ((a1 = ici_array_new(1)) == NULL)
                 return -1;
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             if (statement(p, a1, NULL, "critsect", 1) == -1)
@@ -2080,6 +2167,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
                 return -1;
             if ((a1 = ici_array_new(2)) == NULL)
                 return -1;
+            ici_wb(a);
             *a->a_top++ = objof(a1);
             ici_decref(a1);
             *a->a_top++ = objof(&o_critsect);
@@ -2092,6 +2180,7 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
             if ((a2 = ici_array_new(2)) == NULL)
                 return -1;
             *a1->a_top++ = objof(&o_loop);
+            ici_wb(a1);
             *a1->a_top++ = objof(a2);
             ici_decref(a2);
             /*
@@ -2178,6 +2267,8 @@ statement(ici_parse_t *p, ici_array_t *a, ici_struct_t *sw, char *m, int endme)
         if (ici_stk_push_chk(a, 1))
             return -1;
         *a->a_top++ = objof(&o_end);
+        if (finish_code(a, 0))
+            return -1;
     }
     return 1;
 
@@ -152,6 +152,13 @@ struct ici_parse
 #define OPC_COLON_CARET     0x0001  /* It's a :^ not a : */
 #define OPC_COLON_CALL      0x0002  /* Don't form a method, just call it. */
 
+/*
+ * Set in the op_code field of a call operator (OP_CALL, OP_METHOD_CALL,
+ * OP_ICMETHOD_CALL or OP_SUPER_CALL) when its result is returned at once.
+ * See ici_tail_call_frame().
+ */
+#define OPC_TAIL_CALL       0x0004
+
 /*
  * Expression tree.  This is what the parseing functions build and
  * pass to compile_expr().
@@ -156,6 +156,8 @@ ici_ptr_new(ici_obj_t *a, ici_obj_t *k)
     if ((p = ici_talloc(ici_ptr_t)) == NULL)
         return NULL;
     ICI_OBJ_SET_TFNZ(p, TC_PTR, 0, 1, 0);
+    if (isstruct(a))
+        a->o_flags &= ~S_FRAME; /* It may be the autos of a call. */
     p->p_aggr = a;
     p->p_key = k;
     ici_rego(p);
@@ -213,7 +213,7 @@ do_smash
          */
         if (ici_stk_push_chk(a, 1))
             goto fail;
-        if ((ns = ici_str_new(s, se - s)) == NULL)
+        if ((ns = ici_str_sub(str, s - str->s_chars, se - s)) == NULL)
             goto fail;
         *a->a_top++ = objof(ns);
         ici_decref(ns);
@@ -484,7 +484,7 @@ f_gsub()
         memcpy(s, stringof(*p)->s_chars, stringof(*p)->s_nchars);
         s += stringof(*p)->s_nchars;
     }
-    if ((ns = stringof(ici_atom(objof(ns), 1))) == NULL)
+    if ((ns = ici_str_lazy(ns)) == NULL)
         goto fail;
     ici_decref(a);
     if (!isregexp(ARG(1)))
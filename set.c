@@ -1,6 +1,7 @@
 #define ICI_CORE
 #include "object.h"
 #include "set.h"
+#include "str.h"
 #include "op.h"
 #include "int.h"
 #include "buf.h"
@@ -211,6 +212,7 @@ ici_set_unassign(ici_set_t *s, ici_obj_t *k)
     register ici_obj_t  **ss;
     register ici_obj_t  **ws;   /* Wanted position. */
 
+    k = ici_keyof(k);
     if (*(ss = find_set_slot(s, k)) == NULL)
         return 0;
     --s->s_nels;
@@ -268,6 +270,7 @@ assign_set(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
     }
     else
     {
+        k = ici_keyof(k);
         if (*(e = find_set_slot(setof(o), k)) != NULL)
             return 0;
         if (setof(o)->s_nels >= setof(o)->s_nslots - setof(o)->s_nslots / 4)
@@ -280,6 +283,7 @@ assign_set(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
             e = find_set_slot(setof(o), k);
         }
         ++setof(o)->s_nels;
+        ici_wb(o);
         *e = k;
     }
 
@@ -293,7 +297,7 @@ assign_set(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
 static ici_obj_t *
 fetch_set(ici_obj_t *o, ici_obj_t *k)
 {
-    return *find_set_slot(setof(o), k) == NULL ? objof(&o_null) : objof(ici_one);
+    return *find_set_slot(setof(o), ici_keyof(k)) == NULL ? objof(&o_null) : objof(ici_one);
 }
 
 ici_type_t  set_type =
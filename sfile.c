@@ -262,7 +262,7 @@ ici_open_charbuf(char *data, int size, ici_obj_t *ref, int readonly)
          */
         if (isstring(ref))
         {
-            if ((ref->o_flags & (O_ATOM|ICI_S_SEP_ALLOC)) == ICI_S_SEP_ALLOC)
+            if ((ref->o_flags & (O_ATOM|ICI_S_SEP_ALLOC|ICI_S_READONLY)) == ICI_S_SEP_ALLOC)
                 f = ici_file_new((char *)cb, &ici_strbuf_ftype, NULL, ref);
             else if (readonly)
                 f = ici_file_new((char *)cb, &ici_charbuf_ftype, NULL, ref);
@@ -306,3 +306,54 @@ ici_open_charbuf(char *data, int size, ici_obj_t *ref, int readonly)
         ici_tfree(cb, charbuf_t);
     return f;
 }
+
+/*
+ * Read the next line from f, a file on a char buffer, for getline().  This
+ * finds the newline with memchr() rather than reading a char at a time.
+ * Returns the line, less its newline, or ici_null at the end of the file.
+ * Either way it has been increfed.  Returns NULL on error, usual conventions.
+ */
+ici_obj_t *
+ici_charbuf_getline(ici_file_t *f)
+{
+    charbuf_t   *cb;
+    char        *p;
+    char        *e;
+    char        *q;
+    ici_str_t   *s;
+
+    cb = (charbuf_t *)f->f_file;
+    if (f->f_type == &ici_strbuf_ftype)
+        reattach_string_buffer(cb);
+    p = cb->cb_ptr;
+    e = cb->cb_data + cb->cb_size;
+    if (p < cb->cb_data || p >= e)
+    {
+        cb->cb_eof = 1;
+        ici_incref(ici_null);
+        return ici_null;
+    }
+    if ((q = memchr(p, '\n', e - p)) == NULL)
+    {
+        cb->cb_eof = 1;
+        cb->cb_ptr = q = e;
+    }
+    else
+    {
+        cb->cb_eof = 0;
+        cb->cb_ptr = q + 1;
+    }
+    if
+    (
+        cb->cb_ref != NULL
+        &&
+        isstring(cb->cb_ref)
+        &&
+        cb->cb_data == stringof(cb->cb_ref)->s_chars
+    )
+        return objof(ici_str_sub(stringof(cb->cb_ref), p - cb->cb_data, q - p));
+    if ((s = ici_str_alloc(q - p)) == NULL)
+        return NULL;
+    memcpy(s->s_chars, p, q - p);
+    return objof(ici_str_lazy(s));
+}
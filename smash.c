@@ -39,7 +39,9 @@ smash(char *str, int delim)
 }
 
 /*
- * Just like smash(), but allow delim to be a set of delimiters.
+ * Just like smash(), but allow delim to be a set of delimiters.  The set
+ * is made once (see ici_byteset()) rather than every delimiter being
+ * looked through at each char.
  */
 char **
 ssmash(char *str, char *delims)
@@ -47,24 +49,29 @@ ssmash(char *str, char *delims)
     register char       *p;
     register int        i;
     register char       **ptrs;
+    char                *e;
     int                 n;
+    unsigned char       set[ICI_BYTESETZ];
 
+    ici_byteset(set, delims, strlen(delims));
+    e = str + strlen(str);
     i = 0;
-    for (p = str; (p = strpbrk(p, delims)) != NULL; p++)
+    for (p = str; (p = ici_byte_find(p, e, set)) < e; p++)
         i++;
     /*
      * XENIX compiler bug workaround:
      */
-    n = strlen(str);
+    n = e - str;
     n += (i + 2) * sizeof(char *) + 1;
     if ((ptrs = (char **)ici_alloc(n)) == NULL)
         return NULL;
 
     p = (char *)ptrs + (i + 2) * sizeof(char *);
     strcpy(p, str);
+    e = p + (e - str);
     ptrs[0] = p;
     i = 1;
-    while ((p = strpbrk(p, delims)) != NULL)
+    while ((p = ici_byte_find(p, e, set)) < e)
     {
         *p++ = '\0';
         ptrs[i++] = p;
@@ -72,3 +79,56 @@ ssmash(char *str, char *delims)
     ptrs[i] = NULL;
     return ptrs;
 }
+
+/*
+ * Set the bitmap set (of ICI_BYTESETZ bytes) to hold just the n chars at
+ * chars.  Test a char against it with ici_byte_in().  Building this once
+ * lets a string be split at any of several delimiters without looking
+ * through all of them for every char.
+ */
+void
+ici_byteset(unsigned char *set, char *chars, int n)
+{
+    memset(set, 0, ICI_BYTESETZ);
+    while (--n >= 0)
+    {
+        set[(unsigned char)*chars >> 3] |= 1 << ((unsigned char)*chars & 7);
+        ++chars;
+    }
+}
+
+/*
+ * Return a pointer to the first char from p up to e that is in set (see
+ * ici_byteset()), or e if there is none.
+ */
+char *
+ici_byte_find(char *p, char *e, unsigned char *set)
+{
+    while (e - p >= 4)
+    {
+        if (ici_byte_in(set, p[0]))
+            return p;
+        if (ici_byte_in(set, p[1]))
+            return p + 1;
+        if (ici_byte_in(set, p[2]))
+            return p + 2;
+        if (ici_byte_in(set, p[3]))
+            return p + 3;
+        p += 4;
+    }
+    while (p < e && !ici_byte_in(set, *p))
+        ++p;
+    return p;
+}
+
+/*
+ * Return a pointer to the first char from p up to e that is not in set,
+ * or e if there is none.
+ */
+char *
+ici_byte_span(char *p, char *e, unsigned char *set)
+{
+    while (p < e && ici_byte_in(set, *p))
+        ++p;
+    return p;
+}
@@ -2,6 +2,8 @@
 #include "exec.h"
 #include "src.h"
 #include "str.h"
+#include "array.h"
+#include "buf.h"
 
 /*
  * Mark this and referenced unmarked objects, return memory costs.
@@ -33,6 +35,187 @@ new_src(int lineno, ici_str_t *filename)
     return s;
 }
 
+/*
+ * The source markers of a finished code array are not left among its code,
+ * where each would cost a trip round the execution loop, but are moved to
+ * a line table after its final op (o_end or o_rewind), which is never
+ * reached.  The table is two objects: the first marker (which gives the
+ * file and the first line), then a string of pairs of numbers, the offset
+ * in the code of each marker (after they have been taken out) and its
+ * line.  Each number is the difference from the one before, in 7 bit
+ * groups, least significant first, with the top bit set on all but the
+ * last.
+ */
+static char *
+put_num(char *p, unsigned long n)
+{
+    while (n >= 0x80)
+    {
+        *p++ = (char)(n | 0x80);
+        n >>= 7;
+    }
+    *p++ = (char)n;
+    return p;
+}
+
+static unsigned char *
+get_num(unsigned char *p, unsigned long *n)
+{
+    int         s;
+
+    *n = 0;
+    for (s = 0; *p & 0x80; s += 7)
+        *n |= (unsigned long)(*p++ & 0x7F) << s;
+    *n |= (unsigned long)*p++ << s;
+    return p;
+}
+
+/*
+ * Move the source markers in the finished code array 'a', apart from any in
+ * its first 'keep' elements (which something already knows the offsets of),
+ * to a line table at its end, as described above.  Nothing is done if there
+ * are none, or they are not all of one file in order.
+ *
+ * Returns non-zero on error, usual conventions.
+ */
+int
+ici_src_table(ici_array_t *a, ptrdiff_t keep)
+{
+    ici_obj_t   **e;
+    ici_obj_t   **t;
+    ici_src_t   *first;
+    ici_str_t   *s;
+    char        *p;
+    int         line;
+    ptrdiff_t   off;
+    ptrdiff_t   n;
+
+    assert(a->a_bot == a->a_base);
+    first = NULL;
+    n = 0;
+    line = 0;
+    for (e = a->a_base + keep; e < a->a_top; ++e)
+    {
+        if (!issrc(*e))
+            continue;
+        if (first == NULL)
+            first = srcof(*e);
+        else if
+        (
+            srcof(*e)->s_filename != first->s_filename
+            ||
+            srcof(*e)->s_lineno < line
+        )
+            return 0;
+        line = srcof(*e)->s_lineno;
+        ++n;
+    }
+    if (first == NULL)
+        return 0;
+    if (ici_chkbuf(n * 10))
+        return 1;
+    p = buf;
+    line = first->s_lineno;
+    off = 0;
+    n = 0;
+    for (e = a->a_base + keep; e < a->a_top; ++e)
+    {
+        if (!issrc(*e))
+            continue;
+        p = put_num(p, (e - a->a_base) - n - off);
+        p = put_num(p, srcof(*e)->s_lineno - line);
+        off = (e - a->a_base) - n;
+        line = srcof(*e)->s_lineno;
+        ++n;
+    }
+    if ((s = ici_str_new(buf, p - buf)) == NULL)
+        return 1;
+    if (n < 2 && ici_stk_push_chk(a, 2 - n))
+    {
+        ici_decref(s);
+        return 1;
+    }
+    for (e = t = a->a_base + keep; e < a->a_top; ++e)
+    {
+        if (!issrc(*e))
+            *t++ = *e;
+    }
+    ici_wb(a);
+    *t++ = objof(first);
+    *t++ = objof(s);
+    a->a_top = t;
+    ici_decref(s);
+    return 0;
+}
+
+/*
+ * Find the source marker that applies to the element at offset 'off' of the
+ * code array 'a', and store its line through 'lineno'.  This is the last
+ * one before it, either in the line table or among the code.  The line is
+ * given separately because a table only holds the marker for its first line.
+ * Returns NULL if there is none.
+ */
+ici_src_t *
+ici_src_find(ici_array_t *a, ptrdiff_t off, int *lineno)
+{
+    ici_obj_t           **e;
+    ici_src_t           *first;
+    unsigned char       *p;
+    unsigned char       *q;
+    unsigned long       o;
+    unsigned long       l;
+    ptrdiff_t           at;
+    int                 line;
+
+    if (off < 0 || off >= a->a_top - a->a_bot)
+        return NULL;
+    if
+    (
+        a->a_top - a->a_bot >= 2
+        &&
+        a->a_bot == a->a_base
+        &&
+        isstring(a->a_top[-1])
+        &&
+        issrc(a->a_top[-2])
+    )
+    {
+        first = srcof(a->a_top[-2]);
+        p = (unsigned char *)stringof(a->a_top[-1])->s_chars;
+        q = p + stringof(a->a_top[-1])->s_nchars;
+        at = 0;
+        line = first->s_lineno;
+        if (p < q)
+        {
+            p = get_num(p, &o);
+            p = get_num(p, &l);
+            if ((at += o) <= off)
+            {
+                line += l;
+                while (p < q)
+                {
+                    p = get_num(p, &o);
+                    p = get_num(p, &l);
+                    if ((at += o) > off)
+                        break;
+                    line += l;
+                }
+                *lineno = line;
+                return first;
+            }
+        }
+    }
+    for (e = a->a_bot + off; e >= a->a_bot; --e)
+    {
+        if (issrc(*e))
+        {
+            *lineno = srcof(*e)->s_lineno;
+            return srcof(*e);
+        }
+    }
+    return NULL;
+}
+
 #if 0
 static ici_obj_t *
 fetch_src(ici_obj_t *o, ici_obj_t *k)
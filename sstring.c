@@ -4,15 +4,12 @@
 
 /*
  * Include sstring.h to define static string objects (with 1 ref count
- * and a pesudo size of 1 in o_leafz).
+ * and a pesudo size of 1 in o_leafz).  They are never collected, so they
+ * start out, and stay, marked.  This matters to lookups in the atom pool
+ * during a sweep (see ici_atom_dead()).
  */
-#if KEEP_STRING_HASH
-#   define SSTRING(name, str)    sstring_t ici_ss_##name \
-        = {{TC_STRING, 0, 1, 1}, NULL, NULL, 0, 0, (sizeof str) - 1, NULL, str};
-#else
-#   define SSTRING(name, str)    sstring_t ici_ss_##name \
-        = {{TC_STRING, 0, 1, 1}, NULL, NULL, 0, (sizeof str) - 1, NULL, str};
-#endif
+#define SSTRING(name, str)    sstring_t ici_ss_##name \
+    = {{TC_STRING, O_MARK, 1, 1}, NULL, NULL, 0, (sizeof str) - 1, 0, NULL, str};
 #include "sstring.h"
 #undef  SSTRING
 
@@ -44,10 +41,11 @@ void
 ici_uninit_sstrings(void)
 {
 #define SSTRING(name, str) \
-    ICI_OBJ_SET_TFNZ(SSO(name), TC_STRING, 0, 1, 1); \
+    ICI_OBJ_SET_TFNZ(SSO(name), TC_STRING, O_MARK, 1, 1); \
     ici_ss_##name.s_struct = NULL; \
     ici_ss_##name.s_slot = NULL; \
-    ici_ss_##name.s_vsver = 0;
+    ici_ss_##name.s_vsver = 0; \
+    ici_ss_##name.s_hash = 0;
 #include "sstring.h"
 #undef SSTRING
 }
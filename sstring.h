@@ -158,6 +158,41 @@ SSTRING(calendar, "calendar")
 SSTRING(version, "version")
 SSTRING(cputime, "cputime")
 SSTRING(sleep, "sleep")
+SSTRING(gcfreeze, "gcfreeze")
+SSTRING(gcpolicy, "gcpolicy")
+SSTRING(growth, "growth")
+SSTRING(minheap, "minheap")
+SSTRING(maxheap, "maxheap")
+SSTRING(cpu, "cpu")
+SSTRING(ceiling, "ceiling")
+SSTRING(pause, "pause")
+SSTRING(threads, "threads")
+SSTRING(generational, "generational")
+SSTRING(gcstats, "gcstats")
+SSTRING(heapdump, "heapdump")
+SSTRING(minors, "minors")
+SSTRING(majors, "majors")
+SSTRING(pausetotal, "pausetotal")
+SSTRING(pausemax, "pausemax")
+SSTRING(memused, "memused")
+SSTRING(memlimit, "memlimit")
+SSTRING(objects, "objects")
+SSTRING(frozen, "frozen")
+SSTRING(atoms, "atoms")
+SSTRING(atomsz, "atomsz")
+SSTRING(allocs, "allocs")
+SSTRING(allocmem, "allocmem")
+SSTRING(runs, "runs")
+SSTRING(idleruns, "idleruns")
+SSTRING(types, "types")
+SSTRING(bytes, "bytes")
+SSTRING(freelists, "freelists")
+SSTRING(size, "size")
+SSTRING(free, "free")
+SSTRING(lookasidestats, "lookasidestats")
+SSTRING(hits, "hits")
+SSTRING(misses, "misses")
+SSTRING(flushes, "flushes")
 SSTRING(build, "build")
 SSTRING(printf, "printf")
 SSTRING(getchar, "getchar")
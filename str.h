@@ -9,32 +9,19 @@
  * The following portion of this file exports to ici.h. --ici.h-start--
  */
 
-/*
- * This define enables keeping of the string hash in the string structure to
- * save re-computation. It is potentially recomputed when the atom pool is
- * rebuilt or atoms are being removed from it. Changes to hashing and atom
- * pool usage have reduced the number of times hashes are recomputer and it
- * now seems that *not* keeping the hash value makes things faster overall
- * than keeping it (which must be due to memory bandwidth and cache misses).
- * So it is now ifdefed out. However it's a close thing and it could go back
- * in one day.
- */
-#define KEEP_STRING_HASH 0
-
 struct ici_str
 {
     ici_obj_t       o_head;
     ici_struct_t    *s_struct;      /* Where we were last found on the vs. */
     ici_sslot_t     *s_slot;        /* And our slot. */
     long            s_vsver;        /* The vs version at that time. */
-#   if KEEP_STRING_HASH
-        unsigned long s_hash;  /* String hash code or 0 if not yet computed */
-#   endif
     int             s_nchars;
+    unsigned int    s_hash;         /* Hash, if known and we are an atom. */
     char            *s_chars;
     union
     {
         int         su_nalloc;
+        ici_str_t   *su_parent;     /* See ici_str_sub(). */
         char        su_inline_chars[1]; /* And following bytes. */
     }
                     s_u;
@@ -44,6 +31,11 @@ struct ici_str
  *                      that room is always allocated for a guard '\0' beyond
  *                      this amount.
  *
+ * s_hash               The hash of the string (see ici_hash_string()), kept
+ *                      once the string is an atom, and so can't change.  It
+ *                      is 0 in all other strings.  Where pointers are 8 bytes
+ *                      it fills what would otherwise be padding.
+ *
  * s_chars              This points to the characters of the string, which
  *                      *may* be in a seperate allocation, or may be following
  *                      directly on in the same allocation. The flag
@@ -53,6 +45,10 @@ struct ici_str
  *                      is a seperate allocation (ICI_S_SEP_ALLOC set in
  *                      o_head.o_flags).
  *
+ * s_u.su_parent        If ICI_S_READONLY is set without ICI_S_SEP_ALLOC, the
+ *                      chars are the end of this other string's chars, and
+ *                      it is kept alive by this one (see ici_str_sub()).
+ *
  * su.su_inline_chars   If ICI_S_SEP_ALLOC is *not* set, this is where s_chars will
  *                      be pointing. The actual string chars follow on from this.
  */
@@ -69,10 +65,21 @@ struct ici_str
 /*
  * This flag (in o_head.o_flags) indicates that s_chars points to seperately
  * allocated memory.  If this is the case, s_u.su_nalloc is significant and
- * the memory was allocated with ici_nalloc(s_u.su_nalloc).
+ * the memory was allocated with ici_nalloc(s_u.su_nalloc).  Only such
+ * strings are mutable (unless ICI_S_READONLY is also set).  Any other
+ * string that is not an atom is a lazy atom (see ici_str_lazy()).
  */
 #define ICI_S_SEP_ALLOC     0x20
 
+/*
+ * This flag (in o_head.o_flags) marks a string that is not mutable although
+ * its chars are not its own inline chars.  With ICI_S_SEP_ALLOC they are
+ * a seperate allocation, as in strings built up by += (see
+ * ici_str_append()).  Without it they belong to s_u.su_parent (see
+ * ici_str_sub()).
+ */
+#define ICI_S_READONLY      0x80
+
 /*
  * Macros to assist external modules in getting ICI strings. To use, make
  * an include file called "icistr.h" with your strings, and what you want to
@@ -132,12 +139,10 @@ struct sstring
     ici_struct_t    *s_struct;      /* Where we were last found on the vs. */
     ici_sslot_t *s_slot;        /* And our slot. */
     long        s_vsver;        /* The vs version at that time. */
-#   if KEEP_STRING_HASH
-        unsigned long s_hash;   /* String hash code or 0 if not yet computed */
-#   endif
     int         s_nchars;
+    unsigned int s_hash;        /* Hash, if known and we are an atom. */
     char        *s_chars;
-    char        s_inline_chars[12]; /* Longest string in sstring.h */
+    char        s_inline_chars[16]; /* Longest string in sstring.h */
 };
 
 #define SSTRING(name, str)    extern sstring_t ici_ss_##name;
@@ -147,6 +152,17 @@ struct sstring
 #define SS(name)         ((ici_str_t *)&ici_ss_##name)
 #define SSO(name)        ((ici_obj_t *)&ici_ss_##name)
 
+/*
+ * The string the last s += t into a struct made, as long as nothing has
+ * fetched it from there since (see ici_str_append()).  Every value fetched
+ * from a struct slot, or copied out of one, is passed through this, which
+ * gives the value.
+ */
+extern ici_str_t        *ici_str_tip;
+extern int              ici_str_tip_kept;
+#define ici_fetched(v) \
+    ((v) == objof(ici_str_tip) ? (ici_str_tip = NULL, (v)) : (v))
+
 #endif /* ICI_CORE */
 
 #endif /* ICI_STRING_H */
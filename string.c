@@ -5,6 +5,19 @@
 #include "exec.h"
 #include "int.h"
 #include "primes.h"
+#include <limits.h>
+
+/*
+ * The multiplier and shift used by ici_hash_string(), to suit the size of
+ * an unsigned long.
+ */
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define STR_HASH_MUL    0x9E3779B97F4A7C15UL
+#define STR_HASH_SHIFT  32
+#else
+#define STR_HASH_MUL    0x9E3779B1UL
+#define STR_HASH_SHIFT  16
+#endif
 
 /*
  * How many bytes of memory we need for a string of n chars (single
@@ -12,6 +25,27 @@
  */
 #define STR_ALLOCZ(n)   (offsetof(ici_str_t, s_u) + (n) + 1)
 
+/*
+ * Strings made by ici_str_lazy() of at least this many chars are left as
+ * lazy atoms.
+ */
+#define STR_LAZY_MIN    64
+
+ici_str_t       *ici_str_tip;
+int             ici_str_tip_kept;
+
+/*
+ * Strings of at least this many chars that are the end of a string are made
+ * by ici_str_sub() to share the chars of that string, if they are at least
+ * half of them.
+ */
+#define STR_VIEW_MIN    64
+
+/*
+ * Is this string's chars the end of another's?
+ */
+#define isview(s)       ((objof(s)->o_flags & (ICI_S_SEP_ALLOC|ICI_S_READONLY)) == ICI_S_READONLY)
+
 /*
  * Allocate a new string object (single allocation) large enough to hold
  * nchars characters, and register it with the garbage collector.  Note: This
@@ -37,14 +71,85 @@ ici_str_alloc(int nchars)
     s->s_chars[nchars] = '\0';
     s->s_struct = NULL;
     s->s_slot = NULL;
-#   if KEEP_STRING_HASH
-        s->s_hash = 0;
-#   endif
+    s->s_hash = 0;
     s->s_vsver = 0;
     ici_rego(s);
     return s;
 }
 
+/*
+ * Finish the string s, made by ici_str_alloc() and filled in by the caller,
+ * which must have the only reference to it.  Short strings are made atoms
+ * straight away, as with ici_str_new().  Long ones (such as whole files read
+ * by getfile()) are mostly never used as keys, so they are left as they are
+ * to save hashing them and adding them to the atom pool.  They are still
+ * immutable, and only become atoms if they are used as a key or otherwise
+ * have to be (see ici_keyof() in object.h).  Returns s, or the atom that
+ * replaces it.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+ici_str_t *
+ici_str_lazy(ici_str_t *s)
+{
+    if (s->s_nchars < STR_LAZY_MIN)
+        return stringof(ici_atom(objof(s), 1));
+    return s;
+}
+
+/*
+ * Return a string of the nchars chars of s from index start, with a
+ * reference count of 1, or NULL on error, usual conventions.  Where they run
+ * to the end of an immutable s (as in the rest of a string being worked
+ * through) and are long, the new string just refers to the chars of s
+ * rather than copying them, and keeps s alive (chars in the middle of s
+ * can't be shared this way as they are not followed by a '\0').  Either way
+ * the result is a lazy atom (see ici_str_lazy()).
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+ici_str_t *
+ici_str_sub(ici_str_t *s, int start, int nchars)
+{
+    ici_str_t           *p;
+    ici_str_t           *v;
+
+    assert(start >= 0 && nchars >= 0 && start + nchars <= s->s_nchars);
+    p = isview(s) ? s->s_u.su_parent : s;
+    if
+    (
+        nchars < STR_VIEW_MIN
+        ||
+        start + nchars != s->s_nchars
+        ||
+        (objof(p)->o_flags & (O_ATOM|ICI_S_SEP_ALLOC|ICI_S_READONLY)) == ICI_S_SEP_ALLOC
+        ||
+        nchars < p->s_nchars / 2
+    )
+    {
+        if (nchars < STR_LAZY_MIN)
+            return ici_str_new(s->s_chars + start, nchars);
+        if ((v = ici_str_alloc(nchars)) == NULL)
+            return NULL;
+        memcpy(v->s_chars, s->s_chars + start, nchars);
+        return ici_str_lazy(v);
+    }
+    if ((v = ici_talloc(ici_str_t)) == NULL)
+        return NULL;
+    if (p == ici_str_tip)
+        ici_str_tip = NULL;
+    ICI_OBJ_SET_TFNZ(v, TC_STRING, ICI_S_READONLY, 1, 0);
+    v->s_chars = s->s_chars + start;
+    v->s_nchars = nchars;
+    v->s_u.su_parent = p;
+    v->s_struct = NULL;
+    v->s_slot = NULL;
+    v->s_hash = 0;
+    v->s_vsver = 0;
+    ici_rego(v);
+    return v;
+}
+
 /*
  * Make a new atomic immutable string from the given characters.
  *
@@ -83,9 +188,6 @@ ici_str_new(char *p, int nchars)
         proto.s.s_chars = proto.s.s_u.su_inline_chars;
         memcpy(proto.s.s_chars, p, nchars);
         proto.s.s_chars[nchars] = '\0';
-#       if KEEP_STRING_HASH
-            proto.s.s_hash = 0;
-#       endif
         if ((s = stringof(atom_probe(objof(&proto.s), &po))) != NULL)
         {
             ici_incref(s);
@@ -98,6 +200,7 @@ ici_str_new(char *p, int nchars)
         memcpy((char *)s, (char *)&proto.s, az);
         ICI_OBJ_SET_TFNZ(s, TC_STRING, O_ATOM, 1, az);
         s->s_chars = s->s_u.su_inline_chars;
+        s->s_hash = (unsigned int)atom_hashes[po - atoms];
         ici_rego(s);
         --ici_supress_collect;
         ICI_STORE_ATOM_AND_COUNT(po, s);
@@ -113,9 +216,7 @@ ici_str_new(char *p, int nchars)
     s->s_vsver = 0;
     memcpy(s->s_chars, p, nchars);
     s->s_chars[nchars] = '\0';
-#   if KEEP_STRING_HASH
-        s->s_hash = 0;
-#   endif
+    s->s_hash = 0;
     ici_rego(s);
     return stringof(ici_atom(objof(s), 1));
 }
@@ -191,6 +292,7 @@ ici_str_buf_new(int n)
     s->s_u.su_nalloc = n;
     s->s_vsver = 0;
     s->s_nchars = 0;
+    s->s_hash = 0;
     s->s_struct = NULL;
     s->s_slot = NULL;
     s->s_vsver = 0;
@@ -198,6 +300,29 @@ ici_str_buf_new(int n)
     return s;
 }
 
+/*
+ * Make sure the seperately allocated chars of s have room for n chars and
+ * a guard '\0' (which this stores), doubling them if not.  Returns 0 on
+ * success, 1 on error, usual conventions.
+ */
+static int
+grow_string(ici_str_t *s, int n)
+{
+    char                *chars;
+
+    if (s->s_u.su_nalloc >= n + 1)
+        return 0;
+    n <<= 1;
+    if ((chars = ici_nalloc(n)) == NULL)
+        return 1;
+    memcpy(chars, s->s_chars, s->s_nchars + 1);
+    ici_nfree(s->s_chars, s->s_u.su_nalloc);
+    s->s_chars = chars;
+    s->s_u.su_nalloc = n;
+    s->s_chars[n >> 1] = '\0';
+    return 0;
+}
+
 /*
  * Ensure that the given string has enough allocated memory to hold a string
  * of n characters (and a guard '\0' which this routine stores).  Grows ths
@@ -209,26 +334,67 @@ ici_str_buf_new(int n)
 int
 ici_str_need_size(ici_str_t *s, int n)
 {
-    char                *chars;
     char                n1[30];
 
-    if ((s->o_head.o_flags & (O_ATOM|ICI_S_SEP_ALLOC)) != ICI_S_SEP_ALLOC)
+    if ((s->o_head.o_flags & (O_ATOM|ICI_S_SEP_ALLOC|ICI_S_READONLY)) != ICI_S_SEP_ALLOC)
     {
         sprintf(ici_buf, "attempt to modify an atomic string %s", ici_objname(n1, objof(s)));
         ici_error = ici_buf;
         return 1;
     }
-    if (s->s_u.su_nalloc >= n + 1)
-        return 0;
-    n <<= 1;
-    if ((chars = ici_nalloc(n)) == NULL)
-        return 1;
-    memcpy(chars, s->s_chars, s->s_nchars + 1);
-    ici_nfree(s->s_chars, s->s_u.su_nalloc);
-    s->s_chars = chars;
-    s->s_u.su_nalloc = n;
-    s->s_chars[n >> 1] = '\0';
-    return 0;
+    return grow_string(s, n);
+}
+
+/*
+ * Return s + t, for s += t, with a reference count of 1, or NULL on error,
+ * usual conventions.  If s is ici_str_tip, nothing can refer to it but the
+ * struct slot this result is about to replace it in.  So t is just added to
+ * the end of s and s is returned.  Otherwise this makes a new string.  If
+ * tip is 1 (the += is into a struct) and the result is long, it gets room
+ * to grow and becomes ici_str_tip.  So building up a string with += in a
+ * loop takes time in proportion to its length, not the square of it.
+ *
+ * The += fetched s before t was worked out, and that may have run other
+ * code.  So the fetch (OP_DOTKEEP in exec.c) only keeps ici_str_tip if no
+ * other += is still waiting on it (ici_str_tip_kept).  Were a second one
+ * to add to the tip in place, the first would then add t to the changed
+ * string rather than the one it fetched.
+ */
+ici_str_t *
+ici_str_append(ici_str_t *s, ici_str_t *t, int tip)
+{
+    ici_str_t           *ns;
+    int                 n;
+
+    ici_str_tip_kept = 0;
+    n = s->s_nchars + t->s_nchars;
+    if (s == ici_str_tip)
+    {
+        if (grow_string(s, n))
+            return NULL;
+        memcpy(s->s_chars + s->s_nchars, t->s_chars, t->s_nchars);
+        s->s_nchars = n;
+        s->s_chars[n] = '\0';
+        ici_incref(s);
+        return s;
+    }
+    if (!tip || n < STR_LAZY_MIN)
+    {
+        if ((ns = ici_str_alloc(n)) == NULL)
+            return NULL;
+        memcpy(ns->s_chars, s->s_chars, s->s_nchars);
+        memcpy(ns->s_chars + s->s_nchars, t->s_chars, t->s_nchars);
+        return ici_str_lazy(ns);
+    }
+    if ((ns = ici_str_buf_new(n + 1)) == NULL)
+        return NULL;
+    ns->o_head.o_flags |= ICI_S_READONLY;
+    memcpy(ns->s_chars, s->s_chars, s->s_nchars);
+    memcpy(ns->s_chars + s->s_nchars, t->s_chars, t->s_nchars);
+    ns->s_nchars = n;
+    ns->s_chars[n] = '\0';
+    ici_str_tip = ns;
+    return ns;
 }
 
 /*
@@ -241,6 +407,8 @@ mark_string(ici_obj_t *o)
     o->o_flags |= O_MARK;
     if (o->o_flags & ICI_S_SEP_ALLOC)
         return sizeof(ici_str_t) + stringof(o)->s_u.su_nalloc;
+    else if (isview(o))
+        return sizeof(ici_str_t) + ici_mark(stringof(o)->s_u.su_parent);
     else
         return STR_ALLOCZ(stringof(o)->s_nchars);
 }
@@ -286,11 +454,15 @@ copy_string(ici_obj_t *o)
 static void
 free_string(ici_obj_t *o)
 {
+    if (o == objof(ici_str_tip))
+        ici_str_tip = NULL;
     if (o->o_flags & ICI_S_SEP_ALLOC)
     {
         ici_nfree(stringof(o)->s_chars, stringof(o)->s_u.su_nalloc);
         ici_tfree(o, ici_str_t);
     }
+    else if (isview(o))
+        ici_tfree(o, ici_str_t);
     else
     {
         ici_nfree(o, STR_ALLOCZ(stringof(o)->s_nchars));
@@ -305,15 +477,39 @@ unsigned long
 ici_hash_string(ici_obj_t *o)
 {
     unsigned long       h;
+    unsigned long       w;
+    unsigned char       *p;
+    int                 n;
 
-#   if KEEP_STRING_HASH
-        if (stringof(o)->s_hash != 0)
-            return stringof(o)->s_hash;
-#   endif
-    h = ici_crc(STR_PRIME_0, (const unsigned char *)stringof(o)->s_chars, stringof(o)->s_nchars);
-#   if KEEP_STRING_HASH
-        stringof(o)->s_hash = h;
-#   endif
+    if (stringof(o)->s_hash != 0)
+        return stringof(o)->s_hash;
+    /*
+     * A word at a time: xor it in, multiply, and fold the high half (which
+     * the multiply has mixed best) back down.  The words are read with
+     * memcpy() as the chars need not be aligned.
+     */
+    p = (unsigned char *)stringof(o)->s_chars;
+    n = stringof(o)->s_nchars;
+    h = STR_PRIME_0 ^ (unsigned long)n;
+    for (; n >= (int)sizeof w; n -= sizeof w, p += sizeof w)
+    {
+        memcpy(&w, p, sizeof w);
+        h = (h ^ w) * STR_HASH_MUL;
+        h ^= h >> STR_HASH_SHIFT;
+    }
+    w = 0;
+    memcpy(&w, p, n);
+    h = (h ^ w) * STR_HASH_MUL;
+    /*
+     * Mix once more, so that every char reaches the low bits (which pick
+     * the slot in the atom pool).  Keep it to 32 bits so it fits in s_hash.
+     */
+    h ^= h >> STR_HASH_SHIFT;
+    h *= STR_HASH_MUL;
+    h ^= h >> STR_HASH_SHIFT;
+    h &= 0xFFFFFFFFUL;
+    if (o->o_flags & O_ATOM)
+        stringof(o)->s_hash = (unsigned int)h;
     return h;
 }
 
@@ -351,7 +547,7 @@ assign_string(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
     long        n;
     ici_str_t   *s;
 
-    if (o->o_flags & O_ATOM)
+    if ((o->o_flags & (O_ATOM|ICI_S_SEP_ALLOC|ICI_S_READONLY)) != ICI_S_SEP_ALLOC)
     {
         ici_error = "attempt to assign to an atomic string";
         return 1;
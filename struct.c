@@ -12,16 +12,33 @@
 
 
 /*
- * Generation number of look-up look-asides.  All strings that hold a look-up
- * look-aside to shortcut struct lookups also record a generation number.
- * Whenever something happens that would invalidate such a look-aside (that we
- * can't recover from by some local operation) we bump the generation number.
- * This has the effect of globally invalidating all the current look-asides.
- *
- * This is the global generation (version) number.
+ * Source of look-up look-aside versions.  All strings that hold a look-up
+ * look-aside to shortcut struct lookups record the struct that the lookup
+ * was based on, and that struct's version (s_vsver) at the time.  Each
+ * struct is given a new version from this counter when it is made, and
+ * whenever something happens that would invalidate look-asides based on it
+ * (that we can't recover from by some local operation).  So a change to one
+ * struct leaves the look-asides of all the others alone.  Versions are
+ * never re-used, so a struct made where a freed one was doesn't inherit its
+ * look-asides.
  */
 long    ici_vsver   = 1;
 
+/*
+ * Counts of struct lookups that were, and weren't, satisfied by the
+ * look-aside, and of the times all look-asides were invalidated at once.
+ * See lookasidestats().
+ */
+long    ici_lookaside_hits;
+long    ici_lookaside_misses;
+long    ici_lookaside_flushes;
+
+/*
+ * Source of inline cache epochs.  Changing it invalidates every inline
+ * cache at once.  See ici_icache_t in struct.h.
+ */
+long    ici_icache_epoch = 1;
+
 /*
  * Hash a pointer to get the initial position in a struct has table.
  */
@@ -47,6 +64,24 @@ find_raw_slot(ici_struct_t *s, ici_obj_t *k)
     return sl;
 }
 
+/*
+ * The slow path of ici_struct_wb_slot(). The lookaside slot 'sl' is not in
+ * 's', so find which of its supers it is in and apply the write barrier to
+ * that. A valid lookaside is only ever established through a chain of
+ * structs.
+ */
+void
+ici_struct_wb_super(ici_struct_t *s, ici_sslot_t *sl)
+{
+    do
+    {
+        s = structof(s->o_head.o_super);
+        assert(s != NULL && isstruct(s));
+    }
+    while (sl < s->s_slots || sl >= s->s_slots + s->s_nslots);
+    ici_wb(s);
+}
+
 /*
  * Mark this and referenced unmarked objects, return memory costs.
  * See comments on t_mark() in object.h.
@@ -94,10 +129,10 @@ mark_struct(ici_obj_t *o)
 static void
 free_struct(ici_obj_t *o)
 {
+    ici_struct_changing(o);
     if (structof(o)->s_slots != NULL)
         ici_nfree(structof(o)->s_slots, structof(o)->s_nslots * sizeof(ici_sslot_t));
     ici_tfree(o, ici_struct_t);
-    ++ici_vsver;
 }
 
 /*
@@ -121,6 +156,7 @@ ici_struct_new(void)
     s->s_slots = NULL;
     s->s_nels = 0;
     s->s_nslots = 4; /* Must be power of 2. */
+    s->s_vsver = ++ici_vsver;
     if ((s->s_slots = (ici_sslot_t*)ici_nalloc(4 * sizeof(ici_sslot_t))) == NULL)
     {
         ici_tfree(s, ici_struct_t);
@@ -192,10 +228,10 @@ hash_struct(ici_obj_t *o)
 }
 
 /*
- * Invalidate the lookup lookaside of any string keyed entries in
- * this struct. This can be done for small structs as an alternative
- * to ++ici_vsver which completely invalidates all lookasides. Only
- * call this if you know exactly what you are doing.
+ * Point the lookup lookaside of any string keyed entries in this struct
+ * at this struct. This can be done for small structs that have just been
+ * made, so that their first lookups needn't miss. Only call this if you
+ * know exactly what you are doing.
  */
 void
 ici_invalidate_struct_lookaside(ici_struct_t *s)
@@ -211,8 +247,7 @@ ici_invalidate_struct_lookaside(ici_struct_t *s)
         if (sl->sl_key != NULL && isstring(sl->sl_key))
         {
             str = stringof(sl->sl_key);
-            /*stringof(sl->sl_key)->s_vsver = 0;*/
-            str->s_vsver = ici_vsver;
+            str->s_vsver = s->s_vsver;
             str->s_struct = s;
             str->s_slot = sl;
         }
@@ -220,6 +255,41 @@ ici_invalidate_struct_lookaside(ici_struct_t *s)
     }
 }
 
+/*
+ * Invalidate all lookup look-asides, by giving every struct a new version.
+ * This takes time in proportion to the size of the heap. It is needed when
+ * the super of an object that look-asides may have been found through is
+ * changed, as we can't tell which look-asides those are.
+ *
+ * This --func-- forms part of the --ici-api--.
+ */
+void
+ici_invalidate_lookasides(void)
+{
+    ici_obj_t           **a;
+
+    for (a = objs; a < objs_top; ++a)
+    {
+        if (isstruct(*a))
+        {
+            structof(*a)->s_vsver = ++ici_vsver;
+            (*a)->o_flags &= ~S_LOOKASIDE_VIA;
+        }
+    }
+    ++ici_lookaside_flushes;
+}
+
+/*
+ * Invalidate all inline caches because the struct 's', which some may
+ * depend on, is about to change.  Use through ici_struct_changing().
+ */
+void
+ici_invalidate_icaches(ici_struct_t *s)
+{
+    objof(s)->o_flags &= ~S_ICACHED;
+    ++ici_icache_epoch;
+}
+
 /*
  * Return a copy of the given object, or NULL on error.
  * See the comment on t_copy() in object.h.
@@ -238,16 +308,22 @@ copy_struct(ici_obj_t *o)
     ns->s_nels = 0;
     ns->s_nslots = 0;
     ns->s_slots = NULL;
+    ns->s_vsver = ++ici_vsver;
     ici_rego(ns);
     if ((ns->s_slots = (ici_sslot_t*)ici_nalloc(s->s_nslots * sizeof(ici_sslot_t))) == NULL)
         goto fail;
     memcpy((char *)ns->s_slots, (char *)s->s_slots, s->s_nslots*sizeof(ici_sslot_t));
     ns->s_nels = s->s_nels;
     ns->s_nslots = s->s_nslots;
+    if (ici_str_tip != NULL)
+    {
+        ici_sslot_t *sl;
+
+        for (sl = s->s_slots; sl < s->s_slots + s->s_nslots; ++sl)
+            ici_fetched(sl->sl_value);
+    }
     if (ns->s_nslots <= 16)
         ici_invalidate_struct_lookaside(ns);
-    else
-        ++ici_vsver;
     return objof(ns);
 
 fail:
@@ -255,41 +331,108 @@ fail:
     return NULL;
 }
 
-#ifdef  NOTYET
+/*
+ * Return a struct of auto variables, with the super 'sup', for a call of
+ * the function 'f', or NULL on error.  This is a copy of the function's
+ * prototype autos, but if the struct from an earlier call was kept (see
+ * keep_autos()) that is used rather than making a new one.  The result
+ * has been ici_incref()ed and has S_FRAME set.
+ */
 ici_struct_t *
-copy_autos(ici_func_t *f)
+copy_autos(ici_func_t *f, ici_objwsup_t *sup)
 {
-    ici_struct_t    *ns;
     ici_struct_t    *s;
-    int         nslots;
-
-    if (f->f_nautos == 0)
-        return structof(copy_struct(f->f_autos));
-    s = f->f_autos;
-    nslots = f->f_nautos + (f->f_nautos >> 1);
-    ns = (ici_struct_t *)ici_nalloc(sizeof(ici_struct_t) + nslots * sizeof(ici_sslot_t));
-    if (ns == NULL)
-        return NULL;
-    ICI_OBJ_SET_TFNZ(ns, TC_STRUCT, O_SUPER, 1, 0);
-    ns->o_head.o_super = s->o_head.o_super;
-    ns->s_nels = 0;
-    ns->s_nslots = 0;
-    ns->s_slots = (ici_sslot_t*)(ns + 1);
-    memcpy((char *)ns->s_slots, (char *)s->s_slots, s->s_nslots*sizeof(ici_sslot_t));
-    ns->s_nels = s->s_nels;
-    ns->s_nslots = nslots;
-    ici_rego(ns);
-    if (ns->s_nslots <= 16)
-        ici_invalidate_struct_lookaside(ns);
-    else
-        ++ici_vsver;
-    return objof(ns);
 
-fail:
-    ici_decref(ns);
-    return NULL;
+    if ((s = f->f_frame) == NULL)
+    {
+        if ((s = structof(copy_struct(objof(f->f_autos)))) == NULL)
+            return NULL;
+        s->o_head.o_super = sup;
+        objof(s)->o_flags |= S_FRAME;
+        return s;
+    }
+    f->f_frame = NULL;
+    ici_incref(s);
+    objof(s)->o_flags |= S_FRAME;
+    /*
+     * The caller stores the arguments straight into the slots.
+     */
+    ici_wb(s);
+    if (s->o_head.o_super != sup)
+    {
+        /*
+         * Lookasides found through this struct into its old super are
+         * now wrong, and we can't tell which they are.
+         */
+        ici_struct_changing(s);
+        s->o_head.o_super = sup;
+        s->s_vsver = ++ici_vsver;
+    }
+    if (s->s_nslots <= 16)
+        ici_invalidate_struct_lookaside(s);
+    return s;
+}
+
+/*
+ * The struct 's', which has S_FRAME set, is the auto variables of a
+ * function call that is returning.  If we can, reset it to the function's
+ * prototype autos and keep it for the function's next call.
+ */
+void
+keep_autos(ici_struct_t *s)
+{
+    ici_func_t      *f;
+    ici_struct_t    *a;
+    ici_sslot_t     *sl;
+    ici_sslot_t     *sle;
+    ici_sslot_t     *asl;
+
+    objof(s)->o_flags &= ~S_FRAME;
+    sl = find_raw_slot(s, SSO(_func_));
+    if (sl->sl_key == NULL || !isfunc(sl->sl_value))
+        return;
+    f = funcof(sl->sl_value);
+    a = f->f_autos;
+    if (f->f_frame != NULL || objof(s)->o_nrefs != 0 || s->s_nslots < a->s_nslots)
+        return;
+    ici_wb(s);
+    ici_struct_changing(s);
+    sle = s->s_slots + s->s_nslots;
+    if (s->s_nslots == a->s_nslots)
+    {
+        /*
+         * Same layout, just copy the slots back over.  Strings keyed in
+         * a slot that now gets another key must lose their lookaside.
+         */
+        for (sl = s->s_slots, asl = a->s_slots; sl < sle; ++sl, ++asl)
+        {
+            if (sl->sl_key != asl->sl_key && sl->sl_key != NULL && isstring(sl->sl_key))
+                stringof(sl->sl_key)->s_vsver = 0;
+        }
+        memcpy((char *)s->s_slots, (char *)a->s_slots, s->s_nslots * sizeof(ici_sslot_t));
+    }
+    else
+    {
+        /*
+         * It grew during the call.  Keep the size and put the prototype's
+         * entries back in.
+         */
+        for (sl = s->s_slots; sl < sle; ++sl)
+        {
+            if (sl->sl_key != NULL && isstring(sl->sl_key))
+                stringof(sl->sl_key)->s_vsver = 0;
+        }
+        memset((char *)s->s_slots, 0, s->s_nslots * sizeof(ici_sslot_t));
+        for (asl = a->s_slots + a->s_nslots; --asl >= a->s_slots; )
+        {
+            if (asl->sl_key != NULL)
+                *find_raw_slot(s, asl->sl_key) = *asl;
+        }
+    }
+    s->s_nels = a->s_nels;
+    ici_wb(f);
+    f->f_frame = s;
 }
-#endif
 
 /*
  * Grow the struct s so that it has twice as many slots.
@@ -311,11 +454,18 @@ grow_struct(ici_struct_t *s)
     s->s_nslots *= 2;
     while (--i >= 0)
     {
-        if (oldslots[i].sl_key != NULL)
-            *find_raw_slot(s, oldslots[i].sl_key) = oldslots[i];
+        if (oldslots[i].sl_key == NULL)
+            continue;
+        sl = find_raw_slot(s, oldslots[i].sl_key);
+        *sl = oldslots[i];
+        /*
+         * A look-aside into the old slot, whatever struct it is based on,
+         * now leads to the new one.
+         */
+        if (isstring(sl->sl_key) && stringof(sl->sl_key)->s_slot == &oldslots[i])
+            stringof(sl->sl_key)->s_slot = sl;
     }
     ici_nfree((char *)oldslots, (s->s_nslots / 2) * sizeof(ici_sslot_t));
-    ++ici_vsver;
     return 0;
 }
 
@@ -331,8 +481,10 @@ ici_struct_unassign(ici_struct_t *s, ici_obj_t *k)
     register ici_sslot_t *ss;
     register ici_sslot_t *ws;    /* Wanted position. */
 
+    k = ici_keyof(k);
     if ((ss = find_raw_slot(s, k))->sl_key == NULL)
         return;
+    ici_struct_changing(s);
     --s->s_nels;
     sl = ss;
     /*
@@ -374,6 +526,23 @@ ici_struct_unassign(ici_struct_t *s, ici_obj_t *k)
     ss->sl_value = NULL;
 }
 
+/*
+ * A look-aside based on the struct b is being set to a slot of its super o.
+ * Mark the structs on the way from one to the other so that changing their
+ * supers invalidates it (see f_super()).
+ */
+static void
+lookaside_via(ici_struct_t *b, ici_obj_t *o)
+{
+    ici_objwsup_t       *p;
+
+    for (p = b->o_head.o_super; p != NULL && objof(p) != o; p = p->o_super)
+    {
+        if (isstruct(p))
+            objof(p)->o_flags |= S_LOOKASIDE_VIA;
+    }
+}
+
 /*
  * Do a fetch where we are the super of some other object that is
  * trying to satisfy a fetch. Don't regard the item k as being present
@@ -388,6 +557,7 @@ fetch_super_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t **v, ici_struct_t *b)
 {
     ici_sslot_t         *sl;
 
+    k = ici_keyof(k);
     do
     {
         sl = &structof(o)->s_slots[HASHINDEX(k, structof(o))];
@@ -397,7 +567,9 @@ fetch_super_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t **v, ici_struct_t *b)
             {
                 if (b != NULL && isstring(k))
                 {
-                    stringof(k)->s_vsver = ici_vsver;
+                    if (objof(b) != o)
+                        lookaside_via(b, o);
+                    stringof(k)->s_vsver = b->s_vsver;
                     stringof(k)->s_struct = b;
                     stringof(k)->s_slot = sl;
                     if (o->o_flags & O_ATOM)
@@ -405,7 +577,7 @@ fetch_super_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t **v, ici_struct_t *b)
                     else
                         k->o_flags &= ~S_LOOKASIDE_IS_ATOM;
                 }
-                *v = sl->sl_value;
+                *v = ici_fetched(sl->sl_value);
                 return 1;
             }
             if (--sl < structof(o)->s_slots)
@@ -434,13 +606,16 @@ fetch_struct(ici_obj_t *o, ici_obj_t *k)
         &&
         stringof(k)->s_struct == structof(o)
         &&
-        stringof(k)->s_vsver == ici_vsver
+        stringof(k)->s_vsver == structof(o)->s_vsver
     )
     {
         assert(fetch_super_struct(o, k, &v, NULL) == 1);
         assert(stringof(k)->s_slot->sl_value == v);
-        return stringof(k)->s_slot->sl_value;
+        ++ici_lookaside_hits;
+        return ici_fetched(stringof(k)->s_slot->sl_value);
     }
+    if (isstring(k))
+        ++ici_lookaside_misses;
     switch (fetch_super_struct(o, k, &v, structof(o)))
     {
     case -1: return NULL;               /* Error. */
@@ -454,12 +629,13 @@ fetch_base_struct(ici_obj_t *o, ici_obj_t *k)
 {
     ici_sslot_t         *sl;
 
+    k = ici_keyof(k);
     sl = find_raw_slot(structof(o), k);
     if (sl->sl_key == NULL)
         return objof(&o_null);
     if (isstring(k))
     {
-        stringof(k)->s_vsver = ici_vsver;
+        stringof(k)->s_vsver = structof(o)->s_vsver;
         stringof(k)->s_struct = structof(o);
         stringof(k)->s_slot = sl;
         if (o->o_flags & O_ATOM)
@@ -467,7 +643,7 @@ fetch_base_struct(ici_obj_t *o, ici_obj_t *k)
         else
             k->o_flags &= ~S_LOOKASIDE_IS_ATOM;
     }
-    return sl->sl_value;
+    return ici_fetched(sl->sl_value);
 }
 
 /*
@@ -487,6 +663,7 @@ assign_super_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v, ici_struct_t *b)
 {
     ici_sslot_t         *sl;
 
+    k = ici_keyof(k);
     do
     {
         if ((o->o_flags & O_ATOM) == 0)
@@ -496,10 +673,13 @@ assign_super_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v, ici_struct_t *b)
             {
                 if (sl->sl_key == k)
                 {
+                    ici_wb(o);
                     sl->sl_value = v;
                     if (b != NULL && isstring(k))
                     {
-                        stringof(k)->s_vsver = ici_vsver;
+                        if (objof(b) != o)
+                            lookaside_via(b, o);
+                        stringof(k)->s_vsver = b->s_vsver;
                         stringof(k)->s_struct = b;
                         stringof(k)->s_slot = sl;
                         k->o_flags &= ~S_LOOKASIDE_IS_ATOM;
@@ -535,7 +715,7 @@ assign_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
         &&
         stringof(k)->s_struct == structof(o)
         &&
-        stringof(k)->s_vsver == ici_vsver
+        stringof(k)->s_vsver == structof(o)->s_vsver
         &&
         (k->o_flags & S_LOOKASIDE_IS_ATOM) == 0
     )
@@ -546,9 +726,14 @@ assign_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
 
         assert(fetch_super_struct(o, k, &av, NULL) == 1);
         assert(stringof(k)->s_slot->sl_value == av);
+        ici_struct_wb_slot(structof(o), stringof(k)->s_slot);
         stringof(k)->s_slot->sl_value = v;
+        ++ici_lookaside_hits;
         return 0;
     }
+    if (isstring(k))
+        ++ici_lookaside_misses;
+    k = ici_keyof(k);
     /*
      * Look for it in the base struct.
      */
@@ -583,6 +768,7 @@ assign_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
         ici_error = "attempt to modify an atomic struct";
         return 1;
     }
+    ici_struct_changing(o);
     if (structof(o)->s_nels >= structof(o)->s_nslots - structof(o)->s_nslots / 4)
     {
         /*
@@ -603,10 +789,11 @@ assign_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
     ++structof(o)->s_nels;
     sl->sl_key = k;
 do_assign:
+    ici_wb(o);
     sl->sl_value = v;
     if (isstring(k))
     {
-        stringof(k)->s_vsver = ici_vsver;
+        stringof(k)->s_vsver = structof(o)->s_vsver;
         stringof(k)->s_struct = structof(o);
         stringof(k)->s_slot = sl;
         k->o_flags &= ~S_LOOKASIDE_IS_ATOM;
@@ -628,12 +815,14 @@ assign_base_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
         ici_error = "attempt to modify an atomic struct";
         return 1;
     }
+    k = ici_keyof(k);
     sl = find_raw_slot(structof(o), k);
     if (sl->sl_key != NULL)
         goto do_assign;
     /*
      * Not found. Assign into base struct. We still have sl from above.
      */
+    ici_struct_changing(o);
     if (structof(o)->s_nels >= structof(o)->s_nslots - structof(o)->s_nslots / 4)
     {
         /*
@@ -654,10 +843,11 @@ assign_base_struct(ici_obj_t *o, ici_obj_t *k, ici_obj_t *v)
     ++structof(o)->s_nels;
     sl->sl_key = k;
 do_assign:
+    ici_wb(o);
     sl->sl_value = v;
     if (isstring(k))
     {
-        stringof(k)->s_vsver = ici_vsver;
+        stringof(k)->s_vsver = structof(o)->s_vsver;
         stringof(k)->s_struct = structof(o);
         stringof(k)->s_slot = sl;
         k->o_flags &= ~S_LOOKASIDE_IS_ATOM;
@@ -684,9 +874,116 @@ ici_type_t  struct_type =
     fetch_base_struct
 };
 
+/*
+ * Return a new inline cache for fetches of the key 'k', or NULL on error,
+ * usual conventions.  The result has been ici_incref()ed.
+ */
+ici_icache_t *
+ici_icache_new(ici_str_t *k)
+{
+    ici_icache_t        *ic;
+
+    if ((ic = ici_talloc(ici_icache_t)) == NULL)
+        return NULL;
+    memset((char *)ic, 0, sizeof *ic);
+    ICI_OBJ_SET_TFNZ(ic, TC_ICACHE, 0, 1, 0);
+    ic->ic_key = k;
+    ici_rego(ic);
+    return ic;
+}
+
+/*
+ * Return the value of the key of the inline cache 'ic' in the object 'o',
+ * as ici_fetch() would, or NULL on error, usual conventions.  If 'o' is a
+ * struct that doesn't have the key itself, but its super is in the cache,
+ * the value comes straight from the slot remembered for it.  Otherwise, if
+ * the key is found through a chain of structs, the cache is filled in with
+ * where.
+ */
+ici_obj_t *
+ici_fetch_icached(ici_icache_t *ic, ici_obj_t *o)
+{
+    ici_obj_t           *k;
+    ici_objwsup_t       *sup;
+    ici_objwsup_t       *p;
+    ici_sslot_t         *sl;
+    int                 i;
+
+    k = objof(ic->ic_key);
+    if (!isstruct(o) || (sup = objwsupof(o)->o_super) == NULL)
+        return ici_fetch(o, k);
+    if ((sl = find_raw_slot(structof(o), k))->sl_key != NULL)
+        return ici_fetched(sl->sl_value);
+    for (i = 0; i < ICI_ICACHE_WAYS; ++i)
+    {
+        if (ic->ic_e[i].ice_super == sup && ic->ic_e[i].ice_epoch == ici_icache_epoch)
+        {
+            assert(ici_fetch(o, k) == ic->ic_e[i].ice_slot->sl_value);
+            return ici_fetched(ic->ic_e[i].ice_slot->sl_value);
+        }
+    }
+    for (p = sup; p != NULL && isstruct(p); p = p->o_super)
+    {
+        if ((sl = find_raw_slot(structof(p), k))->sl_key == NULL)
+            continue;
+        /*
+         * Found.  Flag the structs on the way, so that changing them
+         * invalidates the entry, and remember the slot.
+         */
+        for (;;)
+        {
+            objof(sup)->o_flags |= S_ICACHED;
+            if (sup == p)
+                break;
+            sup = sup->o_super;
+        }
+        i = ic->ic_next;
+        ic->ic_next = (i + 1) % ICI_ICACHE_WAYS;
+        ic->ic_e[i].ice_super = objwsupof(o)->o_super;
+        ic->ic_e[i].ice_slot = sl;
+        ic->ic_e[i].ice_epoch = ici_icache_epoch;
+        return ici_fetched(sl->sl_value);
+    }
+    return ici_fetch(o, k);
+}
+
+/*
+ * Mark this and referenced unmarked objects, return memory costs.
+ * See comments on t_mark() in object.h.
+ */
+static unsigned long
+mark_icache(ici_obj_t *o)
+{
+    o->o_flags |= O_MARK;
+    return sizeof(ici_icache_t) + ici_mark(icacheof(o)->ic_key);
+}
+
+/*
+ * Free this object and associated memory (but not other objects).
+ * See the comments on t_free() in object.h.
+ */
+static void
+free_icache(ici_obj_t *o)
+{
+    ici_tfree(o, ici_icache_t);
+}
+
+ici_type_t  icache_type =
+{
+    mark_icache,
+    free_icache,
+    ici_hash_unique,
+    ici_cmp_unique,
+    ici_copy_simple,
+    ici_assign_fail,
+    ici_fetch_fail,
+    "icache"
+};
+
 ici_op_t    o_namelvalue    = {OBJ(TC_OP), NULL, OP_NAMELVALUE};
 ici_op_t    o_colon         = {OBJ(TC_OP), NULL, OP_COLON};
 ici_op_t    o_coloncaret    = {OBJ(TC_OP), NULL, OP_COLONCARET};
 ici_op_t    o_dot           = {OBJ(TC_OP), NULL, OP_DOT};
+ici_op_t    o_icdot         = {OBJ(TC_OP), NULL, OP_ICDOT};
 ici_op_t    o_dotkeep       = {OBJ(TC_OP), NULL, OP_DOTKEEP};
 ici_op_t    o_dotrkeep      = {OBJ(TC_OP), NULL, OP_DOTRKEEP};
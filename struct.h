@@ -20,12 +20,93 @@ struct ici_struct
     int         s_nels;         /* How many slots used. */
     int         s_nslots;       /* How many slots allocated. */
     ici_sslot_t *s_slots;
+    long        s_vsver;        /* Lookaside version, see ici_vsver. */
 };
 #define structof(o)     ((ici_struct_t *)(o))
 #define isstruct(o)     (objof(o)->o_tcode == TC_STRUCT)
 
+/*
+ * This flag (in o_head.o_flags) marks a struct of auto variables made by a
+ * function call that nothing else has a reference to.  When the function
+ * returns, the struct is kept for the function's next call rather than
+ * becoming garbage.  Code that hands out, or holds on to, the struct at
+ * the top of the variable stack (as scope() does) must clear this flag.
+ */
+#define S_FRAME         0x10
+
 /*
  * End of ici.h export. --ici.h-end--
  */
 
+/*
+ * This flag (in o_head.o_flags) indicates that a lookup lookaside based on
+ * some other struct may have been found through this struct, on the way to
+ * one of its supers.  Changing the super of such a struct invalidates all
+ * lookasides (see ici_invalidate_lookasides()).
+ */
+#define S_LOOKASIDE_VIA 0x20
+
+/*
+ * Apply the write barrier (see ici_wb()) before a store into the slot 'sl'
+ * found through the lookup lookaside of a key of the struct 's'. The slot
+ * may belong to 's' or to one of its supers.
+ *
+ * Note that the arguments are subject to multiple expansions.
+ */
+#define ici_struct_wb_slot(s, sl) \
+    ((sl) >= (s)->s_slots && (sl) < (s)->s_slots + (s)->s_nslots \
+        ? ici_wb(s) : ici_struct_wb_super((s), (sl)))
+
+/*
+ * This flag (in o_head.o_flags) indicates that an inline cache (see
+ * ici_icache_t) may hold a look-up that went through this struct on the way
+ * to where its key was found.  Adding or removing a key, changing the super
+ * of, or freeing such a struct invalidates all inline caches (see
+ * ici_invalidate_icaches()).
+ */
+#define S_ICACHED       0x80
+
+/*
+ * The number of receiver supers an inline cache remembers.
+ */
+#define ICI_ICACHE_WAYS 4
+
+/*
+ * An inline cache.  The compiler puts one of these after each o_icdot and
+ * o_icmethod_call in a code array, for a fetch (or method call) of the
+ * constant key ic_key.  It remembers, for the last few supers of the structs
+ * the key was fetched from, the slot it was found in.  So when the receiver
+ * doesn't have the key itself, but its super is one we have seen, the value
+ * can be read straight from the slot without walking the super chain.
+ *
+ * An entry is only good while its ice_epoch matches ici_icache_epoch.  Rather
+ * than holding references, entries are invalidated (by changing the epoch)
+ * when any struct they depend on changes or is freed.
+ */
+struct ici_icache
+{
+    ici_obj_t       o_head;
+    ici_str_t       *ic_key;
+    int             ic_next;        /* The entry to replace next. */
+    struct
+    {
+        ici_objwsup_t   *ice_super;
+        ici_sslot_t     *ice_slot;
+        long            ice_epoch;
+    }
+                    ic_e[ICI_ICACHE_WAYS];
+};
+#define icacheof(o)     ((ici_icache_t *)(o))
+#define isicache(o)     (objof(o)->o_tcode == TC_ICACHE)
+
+/*
+ * Invalidate all inline caches if any might depend on the struct 's'. To
+ * be used before changing what keys 's' has, or its super.
+ *
+ * Note that the argument 's' is subject to multiple expansions.
+ */
+#define ici_struct_changing(s) \
+    ((objof(s)->o_flags & S_ICACHED) != 0 \
+        ? ici_invalidate_icaches(structof(s)) : (void)0)
+
 #endif /* ICI_STRUCT_H */
@@ -363,9 +363,10 @@ f_thread()
     if ((x = ici_new_exec()) == NULL)
         return 1;
     /*
-     * Copy the most-recently-executed source marker to the new thread
-     * to give a useful indication for any errors during startup.
+     * Copy the current source marker to the new thread to give a useful
+     * indication for any errors during startup.
      */
+    ici_set_src(ici_xs.a_top);
     x->x_src = ici_exec->x_src;
     /*
      * Copy all the arguments to the operand stack of the new thread.
@@ -47,6 +47,7 @@ ici_uninit(void)
     ici_exec_t          *x;
     extern ici_str_t    *ici_ver_cache;
     extern ici_regexp_t *ici_smash_default_re;
+    extern ici_str_t    *ici_error_str;
 
     //printf("[start ici_uninit]\n");
     
@@ -75,11 +76,19 @@ ici_uninit(void)
     if (ici_smash_default_re != NULL)
         ici_decref(ici_smash_default_re);
     ici_smash_default_re = NULL;
+    if (ici_error_str != NULL)
+        ici_decref(ici_error_str);
+    ici_error_str = NULL;
 
     /* Call uninitialisation functions for compulsory bits of ICI. */
     uninit_compile();
     uninit_cfunc();
 
+    /*
+     * What was frozen must be freed too.
+     */
+    ici_gc_thaw();
+
     /*
      * Do a GC to free things that might require reference to the
      * exec state before we discard it.